@@ -0,0 +1,16 @@
+//
+//  GNKBenchmarkPrefix.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/28/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#ifdef __OBJC__
+#import <Foundation/Foundation.h>
+
+// Older versions of GNUstep Foundation do not define the initializer annotations used by the library.
+#ifndef NS_DESIGNATED_INITIALIZER
+#define NS_DESIGNATED_INITIALIZER
+#endif
+#endif
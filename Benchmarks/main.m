@@ -0,0 +1,503 @@
+//
+//  main.m
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/28/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <GeneticsKit/GeneticsKit.h>
+#import <sys/resource.h>
+#import <time.h>
+
+#ifdef GNUSTEP
+#import <Foundation/NSDebug.h>
+#endif
+
+/**
+ *  Each benchmark prints a single line of JSON:
+ *
+ *  {"benchmark": "lab.transfer", "iterations": 100000, "ns_per_op": 812.4, "allocations_per_op": 6.0, "peak_rss_kb": 10240}
+ *
+ *  Allocations are counted with GNUstep's allocation debugging, which only counts objects, and are reported as null elsewhere. Peak RSS is the peak for the whole process at the time the benchmark finished.
+ *
+ *  Usage: GeneticsKitBenchmarks [filter] [--scale factor]
+ */
+
+static NSString *GNKBenchmarkFilter;
+static double GNKBenchmarkScale = 1.0;
+
+static uint64_t GNKBenchmarkNanoseconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+}
+
+static long GNKBenchmarkPeakRSSKilobytes(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+#ifdef GNUSTEP
+static unsigned long long GNKBenchmarkAllocationTotal(void)
+{
+    unsigned long long total = 0;
+    
+    const Class *classes = GSDebugAllocationClassList();
+    for (const Class *objectClass = classes; objectClass && *objectClass; objectClass++)
+    {
+        total += GSDebugAllocationTotal(*objectClass);
+    }
+    
+    return total;
+}
+#endif
+
+/**
+ *  Runs a benchmark and prints its results. The block performs `operations` operations each time it is invoked, so results are reported per operation rather than per invocation.
+ */
+static void GNKBenchmark(NSString *name, NSUInteger iterations, NSUInteger operations, void (^block)(void))
+{
+    if (GNKBenchmarkFilter && [name rangeOfString:GNKBenchmarkFilter].location == NSNotFound)
+    {
+        return;
+    }
+    
+    iterations = MAX((NSUInteger)(iterations * GNKBenchmarkScale), (NSUInteger)1);
+    
+    // Warm up caches, such as accessors and parsed traits, so they are not counted.
+    @autoreleasepool
+    {
+        for (NSUInteger i = 0; i < MIN(iterations, (NSUInteger)100); i++)
+        {
+            block();
+        }
+    }
+    
+    uint64_t start = GNKBenchmarkNanoseconds();
+    
+    for (NSUInteger i = 0; i < iterations; i += 100)
+    {
+        @autoreleasepool
+        {
+            for (NSUInteger j = i; j < MIN(i + 100, iterations); j++)
+            {
+                block();
+            }
+        }
+    }
+    
+    uint64_t elapsed = GNKBenchmarkNanoseconds() - start;
+    double nanosecondsPerOperation = (double)elapsed / (double)(iterations * operations);
+    
+    NSString *allocations = @"null";
+
+#ifdef GNUSTEP
+    // Allocation debugging slows every allocation down, so allocations are counted in a separate and shorter run.
+    NSUInteger countedIterations = MIN(iterations, (NSUInteger)1000);
+    
+    GSDebugAllocationActive(YES);
+    unsigned long long allocationsBefore = GNKBenchmarkAllocationTotal();
+    
+    @autoreleasepool
+    {
+        for (NSUInteger i = 0; i < countedIterations; i++)
+        {
+            block();
+        }
+    }
+    
+    unsigned long long allocationsAfter = GNKBenchmarkAllocationTotal();
+    GSDebugAllocationActive(NO);
+    
+    allocations = [NSString stringWithFormat:@"%.2f", (double)(allocationsAfter - allocationsBefore) / (double)(countedIterations * operations)];
+#endif
+    
+    printf("{\"benchmark\": \"%s\", \"iterations\": %lu, \"ns_per_op\": %.2f, \"allocations_per_op\": %s, \"peak_rss_kb\": %ld}\n",
+           name.UTF8String, (unsigned long)iterations, nanosecondsPerOperation, allocations.UTF8String, GNKBenchmarkPeakRSSKilobytes());
+    fflush(stdout);
+}
+
+
+#pragma mark - Fixtures
+
+@interface GNKBenchmarkPerson : NSObject
+
+@property (copy, nonatomic) NSString *identifier;
+@property (copy, nonatomic) NSString *firstName;
+@property (copy, nonatomic) NSString *lastName;
+@property (copy, nonatomic) NSString *email;
+@property (copy, nonatomic) NSString *phone;
+@property (copy, nonatomic) NSString *street;
+@property (copy, nonatomic) NSString *city;
+@property (copy, nonatomic) NSString *country;
+@property (copy, nonatomic) NSString *company;
+@property (copy, nonatomic) NSString *title;
+@property (strong, nonatomic) NSNumber *age;
+@property (strong, nonatomic) NSNumber *score;
+@property (assign, nonatomic) NSInteger loginCount;
+@property (assign, nonatomic) double balance;
+@property (assign, nonatomic) BOOL verified;
+@property (copy, nonatomic) NSArray *tags;
+@property (strong, nonatomic) GNKBenchmarkPerson *manager;
+
+@end
+
+@implementation GNKBenchmarkPerson
+@end
+
+static NSDictionary *GNKBenchmarkRecord(NSUInteger index)
+{
+    return @{@"id": [NSString stringWithFormat:@"person-%lu", (unsigned long)index],
+             @"first_name": @"Harry",
+             @"last_name": [NSString stringWithFormat:@"Potter %lu", (unsigned long)index],
+             @"contact": @{@"email": @"harry@hogwarts.edu",
+                           @"phone": @"555-0100",
+                           @"address": @{@"street": @"4 Privet Drive",
+                                         @"city": @"Little Whinging",
+                                         @"country": @"UK"}},
+             @"employment": @{@"company": @"Ministry of Magic",
+                              @"title": @"Auror"},
+             @"age": @(17 + index % 50),
+             @"score": @(index * 0.5),
+             @"login_count": @(index % 1000),
+             @"balance": @(index * 1.25),
+             @"verified": @(index % 2 == 0),
+             @"tags": @[@"gryffindor", @"seeker", @"wizard"],
+             @"unmapped": @{@"history": @[@1, @2, @3, @4, @5, @6, @7, @8]}};
+}
+
+static GNKGenome *GNKBenchmarkGenome(void)
+{
+    return [GNKGenome genomeWithGenes:@[GNKMakeGene(@"id", @selector(identifier)),
+                                        GNKMakeGene(@"first_name", @selector(firstName)),
+                                        GNKMakeGene(@"last_name", @selector(lastName)),
+                                        GNKMakeGene(@"contact.email", @selector(email)),
+                                        GNKMakeGene(@"contact.phone", @selector(phone)),
+                                        GNKMakeGene(@"contact.address.street", @selector(street)),
+                                        GNKMakeGene(@"contact.address.city", @selector(city)),
+                                        GNKMakeGene(@"contact.address.country", @selector(country)),
+                                        GNKMakeGene(@"employment.company", @selector(company)),
+                                        GNKMakeGene(@"employment.title", @selector(title)),
+                                        GNKMakeGene(@"age", @selector(age)),
+                                        GNKMakeGene(@"score", @selector(score)),
+                                        GNKMakeGene(@"login_count", @selector(loginCount)),
+                                        GNKMakeGene(@"balance", @selector(balance)),
+                                        GNKMakeGene(@"verified", @selector(verified)),
+                                        GNKMakeGene(@"tags", @selector(tags))]];
+}
+
+/**
+ *  A record whose manager, and manager's manager, are nested records of their own, so the genes of GNKBenchmarkNestedGenome share prefixes several levels deep.
+ */
+static NSDictionary *GNKBenchmarkNestedRecord(NSUInteger index)
+{
+    NSMutableDictionary *record = [GNKBenchmarkRecord(index) mutableCopy];
+    NSMutableDictionary *manager = [GNKBenchmarkRecord(index + 1) mutableCopy];
+    manager[@"manager"] = GNKBenchmarkRecord(index + 2);
+    record[@"manager"] = manager;
+    
+    return record;
+}
+
+static GNKBenchmarkPerson *GNKBenchmarkNestedPerson(void)
+{
+    GNKBenchmarkPerson *person = [GNKBenchmarkPerson new];
+    person.manager = [GNKBenchmarkPerson new];
+    person.manager.manager = [GNKBenchmarkPerson new];
+    
+    return person;
+}
+
+/**
+ *  The genes of GNKBenchmarkGenome repeated for the manager and the manager's manager, for 48 genes in all. Receiving key paths follow the same prefixes, or are flattened into single keys when `flatten` is YES so the genome can fill a dictionary.
+ */
+static GNKGenome *GNKBenchmarkNestedGenome(BOOL flatten)
+{
+    NSArray *keyPaths = @[@[@"id", @"identifier"],
+                          @[@"first_name", @"firstName"],
+                          @[@"last_name", @"lastName"],
+                          @[@"contact.email", @"email"],
+                          @[@"contact.phone", @"phone"],
+                          @[@"contact.address.street", @"street"],
+                          @[@"contact.address.city", @"city"],
+                          @[@"contact.address.country", @"country"],
+                          @[@"employment.company", @"company"],
+                          @[@"employment.title", @"title"],
+                          @[@"age", @"age"],
+                          @[@"score", @"score"],
+                          @[@"login_count", @"loginCount"],
+                          @[@"balance", @"balance"],
+                          @[@"verified", @"verified"],
+                          @[@"tags", @"tags"]];
+    
+    NSMutableArray *genes = [NSMutableArray arrayWithCapacity:keyPaths.count * 3];
+    for (NSString *prefix in @[@"", @"manager.", @"manager.manager."])
+    {
+        for (NSArray *pair in keyPaths)
+        {
+            NSString *receivingKeyPath = [prefix stringByAppendingString:pair[1]];
+            if (flatten)
+            {
+                receivingKeyPath = [receivingKeyPath stringByReplacingOccurrencesOfString:@"." withString:@"_"];
+            }
+            
+            [genes addObject:GNKMakeGene([prefix stringByAppendingString:pair[0]], receivingKeyPath)];
+        }
+    }
+    
+    return [GNKGenome genomeWithGenes:genes];
+}
+
+#pragma mark - Benchmarks
+
+static void GNKBenchmarkTraits(void)
+{
+    GNKBenchmarkPerson *person = [GNKBenchmarkPerson new];
+    person.firstName = @"Harry";
+    person.manager = [GNKBenchmarkPerson new];
+    person.manager.lastName = @"Dumbledore";
+    
+    NSDictionary *record = GNKBenchmarkRecord(0);
+    
+    id<GNKReceivingTrait> keyTrait = [GNKTrait traitWithKey:@"firstName"];
+    GNKBenchmark(@"trait.key.get.object", 1000000, 1, ^{
+        [keyTrait traitValueFromObject:person];
+    });
+    
+    GNKBenchmark(@"trait.key.set.object", 1000000, 1, ^{
+        [keyTrait setTraitValue:@"Harry" onObject:person];
+    });
+    
+    id<GNKReceivingTrait> dictionaryTrait = [GNKTrait traitWithKey:@"first_name"];
+    GNKBenchmark(@"trait.key.get.dictionary", 1000000, 1, ^{
+        [dictionaryTrait traitValueFromObject:record];
+    });
+    
+    id<GNKReceivingTrait> keyPathTrait = [GNKTrait traitWithKey:@"manager.lastName"];
+    GNKBenchmark(@"trait.key_path.get.object", 1000000, 1, ^{
+        [keyPathTrait traitValueFromObject:person];
+    });
+    
+    NSArray *array = @[@0, @1, @2, @3, @4, @5, @6, @7];
+    id<GNKReceivingTrait> indexTrait = [GNKTrait traitWithIndex:5];
+    GNKBenchmark(@"trait.index.get", 1000000, 1, ^{
+        [indexTrait traitValueFromObject:array];
+    });
+    
+    id<GNKReceivingTrait> sparseIndexTrait = [GNKTrait traitWithIndex:500];
+    GNKBenchmark(@"trait.index.set.sparse", 10000, 1, ^{
+        [sparseIndexTrait setTraitValue:@500 onObject:[NSMutableArray array]];
+    });
+    
+    id<GNKReceivingTrait> sequenceTrait = [GNKTrait sequenceOfTraits:@[[GNKTrait traitWithKey:@"contact"],
+                                                                        [GNKTrait traitWithKey:@"address"],
+                                                                        [GNKTrait traitWithKey:@"city"]]];
+    GNKBenchmark(@"trait.sequence.get", 1000000, 1, ^{
+        [sequenceTrait traitValueFromObject:record];
+    });
+    
+    id<GNKSourceTrait> aggregateTrait = [GNKTrait aggregateOfTraits:@[[GNKTrait traitWithKey:@"first_name"],
+                                                                      [GNKTrait traitWithKey:@"last_name"],
+                                                                      [GNKTrait traitWithKey:@"age"]]];
+    GNKBenchmark(@"trait.aggregate.get", 1000000, 1, ^{
+        [aggregateTrait traitValueFromObject:record];
+    });
+}
+
+static void GNKBenchmarkTraitConversion(void)
+{
+    GNKBenchmark(@"convert.string.cached", 1000000, 1, ^{
+        [@"contact.address[2].city" GNKSourceTraitValue];
+    });
+    
+    // More unique strings than the parsed trait cache holds, so every conversion parses its string.
+    NSMutableArray *strings = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 4096; i++)
+    {
+        [strings addObject:[NSString stringWithFormat:@"contact.address%lu[%lu].city", (unsigned long)i, (unsigned long)(i % 8)]];
+    }
+    
+    __block NSUInteger stringIndex = 0;
+    GNKBenchmark(@"convert.string.uncached", 100000, 1, ^{
+        [strings[stringIndex++ % strings.count] GNKSourceTraitValue];
+    });
+    
+    GNKBenchmark(@"gene.make", 200000, 1, ^{
+        GNKMakeGene(@"contact.email", @selector(email));
+    });
+    
+    // The same gene converted by hand, so the difference from gene.make is the cost of resolving what each argument is.
+    GNKBenchmark(@"gene.make.baseline", 200000, 1, ^{
+        (void)[[GNKGene alloc] initWithSourceTrait:[@"contact.email" GNKSourceTraitValue] receivingTrait:[@"email" GNKReceivingTraitValue] transformer:nil];
+    });
+    
+    NSValueTransformer *transformer = [NSValueTransformer valueTransformerForName:NSNegateBooleanTransformerName];
+    GNKBenchmark(@"gene.make.transformer", 200000, 1, ^{
+        GNKMakeGene(@"contact.active", @"active", transformer);
+    });
+    
+    GNKBenchmark(@"genome.compile.16", 20000, 1, ^{
+        GNKBenchmarkGenome();
+    });
+    
+    GNKBenchmark(@"genome.compile.48", 5000, 1, ^{
+        GNKBenchmarkNestedGenome(NO);
+    });
+}
+
+static void GNKBenchmarkLab(void)
+{
+    GNKGenome *genome = GNKBenchmarkGenome();
+    NSArray *genes = genome.genes;
+    NSDictionary *record = GNKBenchmarkRecord(1);
+    
+    GNKBenchmark(@"lab.transfer.16_genes", 100000, 1, ^{
+        [GNKLab transferTraitsFromSource:record receiver:[GNKBenchmarkPerson new] compiledGenome:genome options:0];
+    });
+    
+    GNKBenchmark(@"lab.transfer.16_genes.uncompiled", 20000, 1, ^{
+        [GNKLab transferTraitsFromSource:record receiver:[GNKBenchmarkPerson new] genome:genes options:0];
+    });
+    
+    GNKBenchmark(@"lab.transfer.dictionary", 100000, 1, ^{
+        [GNKLab transferTraitsFromSource:record receiver:[NSMutableDictionary dictionary] compiledGenome:genome options:0];
+    });
+    
+    // Each gene set through its traits, as transfers to dictionaries did before they were set directly.
+    GNKBenchmark(@"lab.transfer.dictionary.baseline", 100000, 1, ^{
+        NSMutableDictionary *receiver = [NSMutableDictionary dictionary];
+        for (GNKGene *gene in genes)
+        {
+            [gene.receivingTrait setTraitValue:[gene.sourceTrait traitValueFromObject:record] onObject:receiver];
+        }
+    });
+    
+    NSMutableArray *indexGenes = [NSMutableArray arrayWithCapacity:genes.count];
+    for (GNKGene *gene in genes)
+    {
+        [indexGenes addObject:GNKMakeGene(gene.sourceTrait, (NSInteger)indexGenes.count)];
+    }
+    
+    GNKGenome *indexGenome = [GNKGenome genomeWithGenes:indexGenes];
+    
+    GNKBenchmark(@"lab.transfer.array", 100000, 1, ^{
+        [GNKLab transferTraitsFromSource:record receiver:[NSMutableArray array] compiledGenome:indexGenome options:0];
+    });
+    
+    GNKBenchmark(@"lab.transfer.array.baseline", 100000, 1, ^{
+        NSMutableArray *receiver = [NSMutableArray array];
+        for (GNKGene *gene in indexGenes)
+        {
+            [gene.receivingTrait setTraitValue:[gene.sourceTrait traitValueFromObject:record] onObject:receiver];
+        }
+    });
+    
+    GNKGenome *nestedGenome = GNKBenchmarkNestedGenome(NO);
+    NSArray *nestedGenes = nestedGenome.genes;
+    NSDictionary *nestedRecord = GNKBenchmarkNestedRecord(1);
+    
+    GNKBenchmark(@"lab.transfer.48_genes", 50000, 1, ^{
+        [GNKLab transferTraitsFromSource:nestedRecord receiver:GNKBenchmarkNestedPerson() compiledGenome:nestedGenome options:0];
+    });
+    
+    GNKBenchmark(@"lab.transfer.48_genes.uncompiled", 5000, 1, ^{
+        [GNKLab transferTraitsFromSource:nestedRecord receiver:GNKBenchmarkNestedPerson() genome:nestedGenes options:0];
+    });
+    
+    GNKGenome *flatGenome = GNKBenchmarkNestedGenome(YES);
+    NSArray *flatGenes = flatGenome.genes;
+    
+    GNKBenchmark(@"lab.transfer.48_genes.dictionary", 50000, 1, ^{
+        [GNKLab transferTraitsFromSource:nestedRecord receiver:[NSMutableDictionary dictionary] compiledGenome:flatGenome options:0];
+    });
+    
+    GNKBenchmark(@"lab.transfer.48_genes.dictionary.baseline", 50000, 1, ^{
+        NSMutableDictionary *receiver = [NSMutableDictionary dictionary];
+        for (GNKGene *gene in flatGenes)
+        {
+            [gene.receivingTrait setTraitValue:[gene.sourceTrait traitValueFromObject:nestedRecord] onObject:receiver];
+        }
+    });
+    
+    [GNKLab setInstrumentationEnabled:YES];
+    
+    GNKBenchmark(@"lab.transfer.16_genes.instrumented", 100000, 1, ^{
+        [GNKLab transferTraitsFromSource:record receiver:[GNKBenchmarkPerson new] compiledGenome:genome options:0];
+    });
+    
+    [GNKLab setInstrumentationEnabled:NO];
+    [GNKLab resetGeneStatistics];
+    
+    GNKBenchmarkPerson *person = [GNKBenchmarkPerson new];
+    [GNKLab transferTraitsFromSource:record receiver:person compiledGenome:genome options:0];
+    
+    GNKBenchmark(@"lab.diff.unchanged.find", 100000, 1, ^{
+        [GNKLab findGenesWithDifferentTraitsFromSource:record receiver:person compiledGenome:genome options:0];
+    });
+    
+    GNKBenchmark(@"lab.diff.unchanged.has", 100000, 1, ^{
+        [GNKLab hasDifferentTraitsFromSource:record receiver:person compiledGenome:genome options:0];
+    });
+    
+    NSMutableArray *records = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 10000; i++)
+    {
+        [records addObject:GNKBenchmarkRecord(i)];
+    }
+    
+    GNKBenchmark(@"lab.transfer.batch.10000_records", 20, records.count, ^{
+        [GNKLab receiversByTransferringTraitsFromSources:records compiledGenome:genome options:0 chunkSize:0 receiverFactory:^id(id source) {
+            return [GNKBenchmarkPerson new];
+        }];
+    });
+    
+    NSData *data = [NSJSONSerialization dataWithJSONObject:records options:0 error:nil];
+    
+    GNKBenchmark(@"lab.transfer.json.10000_records", 10, records.count, ^{
+        [GNKLab receiversByTransferringTraitsFromJSONData:data compiledGenome:genome options:0 receiverFactory:^id(NSUInteger index) {
+            return [GNKBenchmarkPerson new];
+        } error:nil];
+    });
+    
+    GNKBenchmark(@"lab.transfer.json_serialization.10000_records", 10, records.count, ^{
+        NSArray *parsedRecords = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+        for (NSDictionary *parsedRecord in parsedRecords)
+        {
+            [GNKLab transferTraitsFromSource:parsedRecord receiver:[GNKBenchmarkPerson new] compiledGenome:genome options:0];
+        }
+    });
+}
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+            {
+                GNKBenchmarkScale = atof(argv[++i]);
+            }
+            else
+            {
+                GNKBenchmarkFilter = @(argv[i]);
+            }
+        }
+        
+        GNKBenchmarkTraits();
+        GNKBenchmarkTraitConversion();
+        GNKBenchmarkLab();
+    }
+    
+    return 0;
+}
@@ -81,6 +81,15 @@
 }
 
 
+- (void)testInvertedGeneIsCached
+{
+    GNKGene *gene = GNKMakeGene(@"A", @"A'", [GNKTestReversibleTransformer new]);
+    GNKGene *invertedGene = [gene invertedGene];
+    
+    XCTAssertTrue([gene invertedGene] == invertedGene);
+    XCTAssertEqualObjects([invertedGene invertedGene], gene);
+}
+
 #pragma mark - Macro
 
 - (void)testMakeGeneWithSingleArg
@@ -144,6 +153,47 @@
     XCTAssertEqualObjects(gene.receivingTrait, [GNKTrait traitWithIndex:9]);
 }
 
+- (void)testMakeGeneWithIntegerTypes
+{
+    NSUInteger unsignedIndex = 2;
+    long long longLongIndex = 3;
+    unsigned short shortIndex = 4;
+    
+    XCTAssertEqualObjects(GNKMakeGene(@"key", unsignedIndex).receivingTrait, [GNKTrait traitWithIndex:2]);
+    XCTAssertEqualObjects(GNKMakeGene(@"key", longLongIndex).receivingTrait, [GNKTrait traitWithIndex:3]);
+    XCTAssertEqualObjects(GNKMakeGene(@"key", shortIndex).receivingTrait, [GNKTrait traitWithIndex:4]);
+}
+
+- (void)testMakeGeneWithRepeatedArgClasses
+{
+    GNKTrait *traitA = [GNKTrait traitWithKey:@"keyA"];
+    GNKTrait *traitB = [GNKTrait traitWithKey:@"keyB"];
+    NSValueTransformer *transformer = [GNKTestOneWayTransformer new];
+    
+    // The second gene is built from arguments whose classes have already been seen.
+    for (NSUInteger i = 0; i < 2; i++)
+    {
+        GNKGene *gene = GNKMakeGene(traitA, traitB, transformer);
+        
+        XCTAssertEqualObjects(gene.sourceTrait, traitA);
+        XCTAssertEqualObjects(gene.receivingTrait, traitB);
+        XCTAssertEqualObjects(gene.transformer, transformer);
+    }
+}
+
+- (void)testMakeGeneConcurrently
+{
+    NSValueTransformer *transformer = [GNKTestOneWayTransformer new];
+    
+    dispatch_apply(1000, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        GNKGene *gene = (i % 2) ? GNKMakeGene(@"keyA", (NSInteger)i, transformer) : GNKMakeGene([GNKTrait traitWithKey:@"keyA"], @"keyB");
+        
+        XCTAssertEqualObjects(gene.sourceTrait, [GNKTrait traitWithKey:@"keyA"]);
+        XCTAssertEqualObjects(gene.receivingTrait, (i % 2) ? [GNKTrait traitWithIndex:i] : [GNKTrait traitWithKey:@"keyB"]);
+        XCTAssertEqualObjects(gene.transformer, (i % 2) ? transformer : nil);
+    });
+}
+
 @end
 
 
@@ -0,0 +1,201 @@
+//
+//  GNKGenomeTests.m
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/24/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <GeneticsKit/GeneticsKit.h>
+
+@interface GNKCountingSource : NSObject
+
+@property (strong, nonatomic) NSDictionary *payload;
+@property (assign, nonatomic) NSUInteger payloadCount;
+
+@end
+
+@implementation GNKCountingSource
+
+- (NSDictionary *)payload
+{
+    self.payloadCount++;
+    return _payload;
+}
+
+@end
+
+@interface GNKGenomeTests : XCTestCase
+
+@end
+
+@implementation GNKGenomeTests
+
+- (void)testInit
+{
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA"), GNKMakeGene(@"keyB")]];
+    
+    XCTAssertNotNil(genome);
+    XCTAssertEqual(genome.count, 2);
+}
+
+- (void)testDeduplication
+{
+    NSArray *genes = @[GNKMakeGene(@"keyA"),
+                       GNKMakeGene(@"keyB"),
+                       GNKMakeGene(@"keyA"),
+                       GNKMakeGene(@"keyC")];
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:genes];
+    
+    XCTAssertEqual(genome.count, 3);
+    
+    NSArray *expected = @[GNKMakeGene(@"keyA"), GNKMakeGene(@"keyB"), GNKMakeGene(@"keyC")];
+    XCTAssertEqualObjects(genome.genes, expected);
+    XCTAssertEqualObjects([genome geneAtIndex:1], GNKMakeGene(@"keyB"));
+    XCTAssertEqual([genome indexOfGene:GNKMakeGene(@"keyC")], 2);
+    XCTAssertEqual([genome indexOfGene:GNKMakeGene(@"keyD")], NSNotFound);
+}
+
+- (void)testEquality
+{
+    GNKGenome *genomeA = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA"), GNKMakeGene(@"keyB")]];
+    GNKGenome *genomeB = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA"), GNKMakeGene(@"keyB")]];
+    GNKGenome *genomeC = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyB"), GNKMakeGene(@"keyA")]];
+    
+    XCTAssertEqualObjects(genomeA, genomeB);
+    XCTAssertEqual(genomeA.hash, genomeB.hash);
+    XCTAssertFalse([genomeA isEqual:genomeC]);
+    XCTAssertEqualObjects([genomeA copy], genomeA);
+}
+
+- (void)testEnumeration
+{
+    NSArray *genes = @[GNKMakeGene(@"keyA"), GNKMakeGene(@"keyB")];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:genes];
+    
+    NSMutableArray *enumerated = [NSMutableArray array];
+    for (GNKGene *gene in genome)
+    {
+        [enumerated addObject:gene];
+    }
+    
+    XCTAssertEqualObjects(enumerated, genes);
+}
+
+- (void)testTransferTraits
+{
+    NSDictionary *objA = @{@"keyA": @"A",
+                           @"keyB": @"B",
+                           @"keyC": @"C"};
+    NSMutableArray *objB = [NSMutableArray array];
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA", 0),
+                                                     GNKMakeGene(@"keyC", 2)]];
+    
+    [GNKLab transferTraitsFromSource:objA receiver:objB compiledGenome:genome options:0];
+    
+    XCTAssertEqual(objB.count, 3);
+    XCTAssertEqualObjects(objB[0], @"A");
+    XCTAssertEqualObjects(objB[1], [NSNull null]);
+    XCTAssertEqualObjects(objB[2], @"C");
+}
+
+- (void)testDifferentTraits
+{
+    NSDictionary *objA = @{@"keyA": @"A",
+                           @"keyB": @"B",
+                           @"keyC": @"C"};
+    
+    NSArray *objB = @[@"A", [NSNull null], @"C"];
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA", 0),
+                                                     GNKMakeGene(@"keyB", 1),
+                                                     GNKMakeGene(@"keyC", 2)]];
+    
+    NSSet *genes = [GNKLab findGenesWithDifferentTraitsFromSource:objA receiver:objB compiledGenome:genome options:0];
+    
+    XCTAssertEqual(genes.count, 1);
+    XCTAssertEqualObjects([genes anyObject], GNKMakeGene(@"keyB", 1));
+}
+
+- (void)testHasDifferentTraits
+{
+    NSDictionary *objA = @{@"keyA": @"A",
+                           @"keyB": @"B"};
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA", 0),
+                                                     GNKMakeGene(@"keyB", 1)]];
+    
+    XCTAssertFalse([GNKLab hasDifferentTraitsFromSource:objA receiver:@[@"A", @"B"] compiledGenome:genome options:0]);
+    XCTAssertTrue([GNKLab hasDifferentTraitsFromSource:objA receiver:@[@"A", @"C"] compiledGenome:genome options:0]);
+}
+
+- (void)testIndexesOfDifferentTraits
+{
+    NSDictionary *objA = @{@"keyA": @"A",
+                           @"keyB": @"B",
+                           @"keyC": @"C"};
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA", 0),
+                                                     GNKMakeGene(@"keyB", 1),
+                                                     GNKMakeGene(@"keyC", 2)]];
+    
+    NSIndexSet *indexes = [GNKLab indexesOfGenesWithDifferentTraitsFromSource:objA receiver:@[@"A", [NSNull null], @"D"] compiledGenome:genome options:0];
+    
+    NSMutableIndexSet *expected = [NSMutableIndexSet indexSetWithIndex:1];
+    [expected addIndex:2];
+    XCTAssertEqualObjects(indexes, expected);
+    
+    indexes = [GNKLab indexesOfGenesWithDifferentTraitsFromSource:objA receiver:@[@"A", @"B", @"C"] compiledGenome:genome options:0];
+    XCTAssertEqual(indexes.count, 0);
+}
+
+- (void)testInvertedGenome
+{
+    NSValueTransformer *transformer = [NSValueTransformer valueTransformerForName:NSNegateBooleanTransformerName];
+    id<GNKSourceTrait> aggregateTrait = [GNKTrait aggregateOfTraits:@[[GNKTrait traitWithKey:@"keyA"], [GNKTrait traitWithKey:@"keyB"]]];
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA", @"flag", transformer),
+                                                     GNKMakeGene(aggregateTrait, @"both"),
+                                                     GNKMakeGene(@"keyB", @"name")]];
+    
+    GNKGenome *invertedGenome = genome.invertedGenome;
+    
+    XCTAssertEqual(invertedGenome.count, 2);
+    XCTAssertTrue(genome.invertedGenome == invertedGenome);
+    XCTAssertEqualObjects([invertedGenome geneAtIndex:0], [[genome geneAtIndex:0] invertedGene]);
+    XCTAssertEqualObjects([invertedGenome geneAtIndex:1], [[genome geneAtIndex:2] invertedGene]);
+    
+    NSDictionary *source = @{@"flag": @YES, @"name": @"Name"};
+    NSMutableDictionary *receiver = [NSMutableDictionary dictionary];
+    [GNKLab transferTraitsFromSource:source receiver:receiver compiledGenome:invertedGenome options:0];
+    
+    XCTAssertEqualObjects(receiver, (@{@"keyA": @NO, @"keyB": @"Name"}));
+    XCTAssertFalse([GNKLab hasDifferentTraitsFromSource:source receiver:receiver compiledGenome:invertedGenome options:0]);
+}
+
+- (void)testSharedPrefixes
+{
+    GNKCountingSource *source = [GNKCountingSource new];
+    source.payload = @{@"user": @{@"name": @"Name", @"email": @"Email", @"id": @1}};
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"payload.user.name", @"name"),
+                                                     GNKMakeGene(@"payload.user.email", @"email"),
+                                                     GNKMakeGene(@"payload.user", @"user"),
+                                                     GNKMakeGene(@"payload.user.id", @"id"),
+                                                     GNKMakeGene(@"payload.missing.id", @"missing")]];
+    
+    NSMutableDictionary *receiver = [NSMutableDictionary dictionary];
+    [GNKLab transferTraitsFromSource:source receiver:receiver compiledGenome:genome options:0];
+    
+    XCTAssertEqual(source.payloadCount, 1);
+    XCTAssertEqualObjects(receiver[@"name"], @"Name");
+    XCTAssertEqualObjects(receiver[@"email"], @"Email");
+    XCTAssertEqualObjects(receiver[@"user"], source.payload[@"user"]);
+    XCTAssertEqualObjects(receiver[@"id"], @1);
+    XCTAssertNil(receiver[@"missing"]);
+}
+
+@end
@@ -8,11 +8,15 @@
 
 #import <XCTest/XCTest.h>
 #import <GeneticsKit/GeneticsKit.h>
+#import <locale.h>
 
 @interface GNKDummy : NSObject
 @property (copy, nonatomic) NSString *keyA;
 @property (copy, nonatomic) NSString *keyB;
 @property (copy, nonatomic) NSString *keyC;
+@property (assign, nonatomic) NSInteger integerKey;
+@property (assign, nonatomic) double doubleKey;
+@property (assign, nonatomic) BOOL boolKey;
 @end
 
 @interface GNKNilNullTransformer : NSValueTransformer
@@ -21,6 +25,30 @@
 @interface GNKUppercaseTransformer : NSValueTransformer
 @end
 
+@interface GNKBatchUppercaseTransformer : GNKUppercaseTransformer <GNKBatchValueTransformer>
+@property (assign, nonatomic) NSUInteger batchCount;
+@end
+
+@interface GNKExpensiveUppercaseTransformer : GNKUppercaseTransformer <GNKExpensiveValueTransformer>
+@end
+
+@interface GNKExpensiveThrowingTransformer : NSValueTransformer <GNKExpensiveValueTransformer>
+@end
+
+@interface GNKOrderedDummy : GNKDummy
+@property (strong, nonatomic) NSMutableArray *setKeys;
+@property (strong, nonatomic) NSMutableSet *setThreads;
+@end
+
+@interface GNKBatchingDummy : GNKOrderedDummy <GNKChangeBatchingReceiver>
+@property (assign, nonatomic) NSUInteger willChangeCount;
+@property (assign, nonatomic) NSUInteger didChangeCount;
+@property (assign, nonatomic) NSUInteger setCountWhenWillChange;
+@end
+
+@interface GNKMarkingLab : GNKLab
+@end
+
 @interface GNKLabTests : XCTestCase
 
 @end
@@ -63,6 +91,30 @@
     XCTAssertEqualObjects(objB[2], @"c");
 }
 
+- (void)testTransferTraitsWithReusedGenome
+{
+    NSDictionary *objA = @{@"keyA": @"a",
+                           @"keyB": [NSNull null],
+                           @"nested": @{@"keyC": @"c"}};
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@selector(keyA), [GNKUppercaseTransformer new]),
+                                                     GNKMakeGene(@selector(keyB)),
+                                                     GNKMakeGene(@"nested.keyC", @selector(keyC))]];
+    
+    // The first transfer walks the entries, and later transfers run the program compiled once the genome is reused.
+    for (NSUInteger i = 0; i < 3; i++)
+    {
+        GNKDummy *objB = [GNKDummy new];
+        objB.keyB = @"B";
+        
+        [GNKLab transferTraitsFromSource:objA receiver:objB compiledGenome:genome options:0];
+        
+        XCTAssertEqualObjects(objB.keyA, @"A");
+        XCTAssertNil(objB.keyB);
+        XCTAssertEqualObjects(objB.keyC, @"c");
+    }
+}
+
 - (void)testTransferTraitsWithUseNilValuesOption
 {
     GNKLabOptions options = GNKLabDefaultOptions;
@@ -148,6 +200,88 @@
     XCTAssertEqual(objB.keyC, (id)[NSNull null]);
 }
 
+- (void)testTransferTraitsWithScalars
+{
+    GNKDummy *objA = [GNKDummy new];
+    objA.integerKey = 42;
+    objA.doubleKey = 4.2;
+    objA.boolKey = YES;
+    
+    GNKDummy *objB = [GNKDummy new];
+    
+    NSArray *genome = @[GNKMakeGene(@selector(integerKey)),
+                        GNKMakeGene(@selector(doubleKey)),
+                        GNKMakeGene(@selector(boolKey))];
+    
+    [GNKLab transferTraitsFromSource:objA receiver:objB genome:genome options:0];
+    
+    XCTAssertEqual(objB.integerKey, 42);
+    XCTAssertEqual(objB.doubleKey, 4.2);
+    XCTAssertTrue(objB.boolKey);
+    
+    // Mismatched scalar types and non-scalar sources are boxed and converted as before.
+    genome = @[GNKMakeGene(@selector(integerKey), @selector(doubleKey))];
+    
+    [GNKLab transferTraitsFromSource:objA receiver:objB genome:genome options:0];
+    
+    XCTAssertEqual(objB.doubleKey, 42.0);
+    
+    [GNKLab transferTraitsFromSource:@{@"integerKey": @7} receiver:objB genome:@[GNKMakeGene(@selector(integerKey))] options:0];
+    
+    XCTAssertEqual(objB.integerKey, 7);
+}
+
+- (void)testTransferTraitsToCollections
+{
+    NSDictionary *objA = @{@"keyA": @"a",
+                           @"keyB": [NSNull null],
+                           @"keyC": @"c"};
+    
+    NSMutableDictionary *dictionary = [@{@"keyB": @"B", @"keyD": @"D"} mutableCopy];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA", [GNKUppercaseTransformer new]),
+                                                     GNKMakeGene(@"keyB"),
+                                                     GNKMakeGene(@"keyC"),
+                                                     GNKMakeGene(@"keyE")]];
+    
+    [GNKLab transferTraitsFromSource:objA receiver:dictionary compiledGenome:genome options:0];
+    
+    XCTAssertEqualObjects(dictionary, (@{@"keyA": @"A", @"keyC": @"c", @"keyD": @"D"}));
+    
+    NSMutableArray *array = [@[@"0", @"1"] mutableCopy];
+    genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyC", 4),
+                                          GNKMakeGene(@"keyA", 1),
+                                          GNKMakeGene(@"keyD", 2)]];
+    
+    [GNKLab transferTraitsFromSource:objA receiver:array compiledGenome:genome options:0];
+    
+    XCTAssertEqualObjects(array, (@[@"0", @"a", [NSNull null], [NSNull null], @"c"]));
+}
+
+- (void)testTransferTraitsWithDifferentOptionsForCompiledGenome
+{
+    NSDictionary *objA = @{@"keyA": [NSNull null]};
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@selector(keyA), [GNKNilNullTransformer new]),
+                                                     GNKMakeGene(@"keyB", @selector(keyB))]];
+    
+    GNKDummy *objB = [GNKDummy new];
+    objB.keyB = @"B";
+    [GNKLab transferTraitsFromSource:objA receiver:objB compiledGenome:genome options:0];
+    XCTAssertEqualObjects(objB.keyA, @"<NIL>");
+    XCTAssertEqualObjects(objB.keyB, @"B");
+    
+    objB = [GNKDummy new];
+    objB.keyB = @"B";
+    [GNKLab transferTraitsFromSource:objA receiver:objB compiledGenome:genome options:GNKLabUseNilValues | GNKLabSkipPreTranformationNilConversion];
+    XCTAssertEqualObjects(objB.keyA, @"<NULL>");
+    XCTAssertNil(objB.keyB);
+    
+    // Options which do not change how values are transfered share the compiled genome for their other options.
+    objB = [GNKDummy new];
+    [GNKLab transferTraitsFromSource:objA receiver:objB compiledGenome:genome options:GNKLabEvaluateExpensiveGenesConcurrently];
+    XCTAssertEqualObjects(objB.keyA, @"<NIL>");
+}
+
 - (void)testDifferentTraitsWhenInequal
 {
     NSDictionary *objA = @{@"keyA": @"A",
@@ -222,12 +356,522 @@
     XCTAssertEqual(genes.count, 0);
 }
 
+- (void)testPatchWithDifferentTraits
+{
+    NSMutableDictionary *source = [@{@"keyA": @"a", @"keyB": @"b", @"keyC": @"c"} mutableCopy];
+    GNKDummy *receiver = [GNKDummy new];
+    receiver.keyA = @"A";
+    
+    GNKUppercaseTransformer *transformer = [GNKUppercaseTransformer new];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA", transformer),
+                                                     GNKMakeGene(@"keyB", transformer),
+                                                     GNKMakeGene(@"keyC")]];
+    
+    GNKPatch *patch = [GNKLab patchWithDifferentTraitsFromSource:source receiver:receiver compiledGenome:genome options:0];
+    
+    XCTAssertEqual(patch.count, 2);
+    XCTAssertEqualObjects(patch.geneIndexes, [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(1, 2)]);
+    XCTAssertEqualObjects([patch geneAtIndex:0], GNKMakeGene(@"keyB", transformer));
+    XCTAssertEqualObjects([patch valueAtIndex:0], @"B");
+    XCTAssertEqualObjects([patch geneAtIndex:1], GNKMakeGene(@"keyC"));
+    XCTAssertEqualObjects([patch valueAtIndex:1], @"c");
+    
+    // The source is not read again when the patch is applied.
+    source[@"keyB"] = @"changed";
+    
+    GNKDummy *otherReceiver = [GNKDummy new];
+    [GNKLab applyPatch:patch toReceiver:receiver];
+    [GNKLab applyPatch:patch toReceiver:otherReceiver];
+    
+    XCTAssertEqualObjects(receiver.keyA, @"A");
+    XCTAssertEqualObjects(receiver.keyB, @"B");
+    XCTAssertEqualObjects(receiver.keyC, @"c");
+    XCTAssertNil(otherReceiver.keyA);
+    XCTAssertEqualObjects(otherReceiver.keyB, @"B");
+    XCTAssertEqualObjects(otherReceiver.keyC, @"c");
+    
+    XCTAssertEqual([GNKLab patchWithDifferentTraitsFromSource:@{@"keyA": @"a", @"keyB": @"b", @"keyC": @"c"} receiver:receiver compiledGenome:genome options:0].count, 0);
+}
+
+- (void)testBatchTransferTraits
+{
+    NSMutableArray *sources = [NSMutableArray array];
+    NSMutableArray *receivers = [NSMutableArray array];
+    
+    for (NSUInteger i = 0; i < 1000; i++)
+    {
+        [sources addObject:@{@"keyA": [NSString stringWithFormat:@"A%lu", (unsigned long)i],
+                             @"keyB": [NSString stringWithFormat:@"B%lu", (unsigned long)i]}];
+        [receivers addObject:[GNKDummy new]];
+    }
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@selector(keyA)),
+                                                     GNKMakeGene(@"keyB", @selector(keyC))]];
+    
+    [GNKLab transferTraitsFromSources:sources receivers:receivers compiledGenome:genome options:0 chunkSize:7];
+    
+    [receivers enumerateObjectsUsingBlock:^(GNKDummy *receiver, NSUInteger idx, BOOL *stop) {
+        XCTAssertEqualObjects(receiver.keyA, sources[idx][@"keyA"]);
+        XCTAssertNil(receiver.keyB);
+        XCTAssertEqualObjects(receiver.keyC, sources[idx][@"keyB"]);
+    }];
+}
+
+- (void)testBatchTransferTraitsWithReceiverFactory
+{
+    NSMutableArray *sources = [NSMutableArray array];
+    
+    for (NSUInteger i = 0; i < 1000; i++)
+    {
+        [sources addObject:@{@"keyA": [NSString stringWithFormat:@"A%lu", (unsigned long)i]}];
+    }
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@selector(keyA))]];
+    
+    NSArray *receivers = [GNKLab receiversByTransferringTraitsFromSources:sources compiledGenome:genome options:0 chunkSize:0 receiverFactory:^id(id source) {
+        return [GNKDummy new];
+    }];
+    
+    XCTAssertEqual(receivers.count, sources.count);
+    
+    [receivers enumerateObjectsUsingBlock:^(GNKDummy *receiver, NSUInteger idx, BOOL *stop) {
+        XCTAssertTrue([receiver isKindOfClass:[GNKDummy class]]);
+        XCTAssertEqualObjects(receiver.keyA, sources[idx][@"keyA"]);
+    }];
+}
+
+- (void)testBatchTransferTraitsWithLabSubclass
+{
+    NSMutableArray *sources = [NSMutableArray array];
+    NSMutableArray *receivers = [NSMutableArray array];
+    
+    for (NSUInteger i = 0; i < 100; i++)
+    {
+        [sources addObject:@{@"keyA": [NSString stringWithFormat:@"a%lu", (unsigned long)i]}];
+        [receivers addObject:[GNKDummy new]];
+    }
+    
+    GNKBatchUppercaseTransformer *transformer = [GNKBatchUppercaseTransformer new];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@selector(keyA), transformer)]];
+    
+    [GNKMarkingLab transferTraitsFromSources:sources receivers:receivers compiledGenome:genome options:0 chunkSize:10];
+    
+    // Each pair is sent through the overridden method, so the batch transformer is never used for a whole chunk.
+    XCTAssertEqual(transformer.batchCount, 0);
+    
+    [receivers enumerateObjectsUsingBlock:^(GNKDummy *receiver, NSUInteger idx, BOOL *stop) {
+        XCTAssertEqualObjects(receiver.keyA, [sources[idx][@"keyA"] uppercaseString]);
+        XCTAssertEqualObjects(receiver.keyB, @"marked");
+    }];
+    
+    receivers = [[GNKMarkingLab receiversByTransferringTraitsFromSources:sources compiledGenome:genome options:0 chunkSize:10 receiverFactory:^id(id source) {
+        return [GNKDummy new];
+    }] mutableCopy];
+    
+    [receivers enumerateObjectsUsingBlock:^(GNKDummy *receiver, NSUInteger idx, BOOL *stop) {
+        XCTAssertEqualObjects(receiver.keyB, @"marked");
+    }];
+}
+
+- (void)testBatchTransferTraitsRaisesOnCallingThread
+{
+    NSMutableArray *sources = [NSMutableArray array];
+    NSMutableArray *receivers = [NSMutableArray array];
+    
+    for (NSUInteger i = 0; i < 100; i++)
+    {
+        [sources addObject:@{@"keyA": @"a"}];
+        [receivers addObject:[GNKDummy new]];
+    }
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA", @"missingKey")]];
+    
+    XCTAssertThrowsSpecificNamed([GNKLab transferTraitsFromSources:sources receivers:receivers compiledGenome:genome options:0 chunkSize:10], NSException, NSUndefinedKeyException);
+    XCTAssertThrowsSpecificNamed([GNKLab receiversByTransferringTraitsFromSources:sources compiledGenome:genome options:0 chunkSize:10 receiverFactory:^id(id source) {
+        return [GNKDummy new];
+    }], NSException, NSUndefinedKeyException);
+}
+
+- (void)testBatchTransferTraitsWithNilReceiverFromFactory
+{
+    NSMutableArray *sources = [NSMutableArray array];
+    
+    for (NSUInteger i = 0; i < 100; i++)
+    {
+        [sources addObject:@{@"keyA": @(i)}];
+    }
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@selector(keyA))]];
+    
+    XCTAssertThrowsSpecificNamed([GNKLab receiversByTransferringTraitsFromSources:sources compiledGenome:genome options:0 chunkSize:10 receiverFactory:^id(NSDictionary *source) {
+        return [source[@"keyA"] integerValue] == 50 ? nil : [NSMutableDictionary dictionary];
+    }], NSException, NSInvalidArgumentException);
+}
+
+- (void)testBatchTransferTraitsWithBatchTransformer
+{
+    NSMutableArray *sources = [NSMutableArray array];
+    NSMutableArray *receivers = [NSMutableArray array];
+    
+    for (NSUInteger i = 0; i < 100; i++)
+    {
+        // Every other source is missing its value, which should be skipped rather than transformed.
+        [sources addObject:(i % 2 == 0) ? @{@"keyA": [NSString stringWithFormat:@"a%lu", (unsigned long)i], @"keyB": @"b"} : @{@"keyB": @"b"}];
+        [receivers addObject:[GNKDummy new]];
+    }
+    
+    GNKBatchUppercaseTransformer *transformer = [GNKBatchUppercaseTransformer new];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@selector(keyA), transformer),
+                                                     GNKMakeGene(@"keyB", @selector(keyC))]];
+    
+    [GNKLab transferTraitsFromSources:sources receivers:receivers compiledGenome:genome options:0 chunkSize:100];
+    
+    XCTAssertEqual(transformer.batchCount, 1);
+    
+    [receivers enumerateObjectsUsingBlock:^(GNKDummy *receiver, NSUInteger idx, BOOL *stop) {
+        XCTAssertEqualObjects(receiver.keyA, [sources[idx][@"keyA"] uppercaseString]);
+        XCTAssertEqualObjects(receiver.keyC, @"b");
+    }];
+}
+
+- (void)testTransferTraitsFromJSONData
+{
+    NSData *data = [@"{\"skipped\": {\"a\": [1, 2, {\"b\": \"\\\"}\"}]}, "
+                    @"\"user\": {\"name\": \"Caf\\u00e9 \\ud83d\\ude00\", \"age\": 42, \"admin\": true, \"email\": null, \"tags\": [\"x\", \"y\"]}, "
+                    @"\"items\": [{\"id\": 1}, {\"id\": 2.5}]}" dataUsingEncoding:NSUTF8StringEncoding];
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"user.name", @"name"),
+                                                     GNKMakeGene(@"user.age", @"age"),
+                                                     GNKMakeGene(@"user.admin", @"admin"),
+                                                     GNKMakeGene(@"user.email", @"email"),
+                                                     GNKMakeGene(@"user.tags", @"tags"),
+                                                     GNKMakeGene(@"user.tags[1]", @"lastTag"),
+                                                     GNKMakeGene(@"items[1].id", @"secondID"),
+                                                     GNKMakeGene(@"missing.key", @"missing")]];
+    
+    NSMutableDictionary *streamedReceiver = [NSMutableDictionary dictionary];
+    NSError *error;
+    XCTAssertTrue([GNKLab transferTraitsFromJSONData:data receiver:streamedReceiver compiledGenome:genome options:0 error:&error]);
+    XCTAssertNil(error);
+    
+    NSMutableDictionary *parsedReceiver = [NSMutableDictionary dictionary];
+    [GNKLab transferTraitsFromSource:[NSJSONSerialization JSONObjectWithData:data options:0 error:nil] receiver:parsedReceiver compiledGenome:genome options:0];
+    
+    XCTAssertEqualObjects(streamedReceiver, parsedReceiver);
+    XCTAssertEqualObjects(streamedReceiver[@"name"], @"Café \U0001F600");
+    XCTAssertEqualObjects(streamedReceiver[@"age"], @42);
+    XCTAssertEqualObjects(streamedReceiver[@"admin"], @YES);
+    XCTAssertNil(streamedReceiver[@"email"]);
+    XCTAssertEqualObjects(streamedReceiver[@"tags"], (@[@"x", @"y"]));
+    XCTAssertEqualObjects(streamedReceiver[@"lastTag"], @"y");
+    XCTAssertEqualObjects(streamedReceiver[@"secondID"], @2.5);
+    XCTAssertNil(streamedReceiver[@"missing"]);
+}
+
+- (void)testTransferTraitsFromInvalidJSONData
+{
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA")]];
+    NSMutableDictionary *receiver = [NSMutableDictionary dictionary];
+    
+    for (NSString *JSON in @[@"{\"keyA\": \"A\"", @"{\"keyA\": \"A\"} trailing", @"{\"skipped\": [1, 2}, \"keyA\": 1}", @""])
+    {
+        NSError *error;
+        XCTAssertFalse([GNKLab transferTraitsFromJSONData:[JSON dataUsingEncoding:NSUTF8StringEncoding] receiver:receiver compiledGenome:genome options:0 error:&error]);
+        XCTAssertEqualObjects(error.domain, GNKLabErrorDomain);
+        XCTAssertEqual(receiver.count, 0);
+    }
+}
+
+- (void)testTransferTraitsFromJSONDataWithMalformedSkippedValues
+{
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA")]];
+    NSMutableDictionary *receiver = [NSMutableDictionary dictionary];
+    
+    for (NSString *skipped in @[@"[1 2 3]", @"{\"a\" \"b\"}", @"[,,]", @"[1,]", @"{\"a\": 1,}", @"{1: 2}", @"{\"a\"}", @"[1:2]", @"{\"a\": 1 \"b\": 2}", @"[[1] [2]]"])
+    {
+        NSData *data = [[NSString stringWithFormat:@"{\"skipped\": %@, \"keyA\": 1}", skipped] dataUsingEncoding:NSUTF8StringEncoding];
+        XCTAssertNil([NSJSONSerialization JSONObjectWithData:data options:0 error:NULL], @"%@", skipped);
+        
+        NSError *error;
+        XCTAssertFalse([GNKLab transferTraitsFromJSONData:data receiver:receiver compiledGenome:genome options:0 error:&error], @"%@", skipped);
+        XCTAssertEqualObjects(error.domain, GNKLabErrorDomain);
+        XCTAssertEqual(receiver.count, 0);
+    }
+    
+    NSData *data = [@"{\"skipped\": [[], {}, {\"a\": [1, {\"b\": null}]}, \"c\", true], \"keyA\": 1}" dataUsingEncoding:NSUTF8StringEncoding];
+    XCTAssertTrue([GNKLab transferTraitsFromJSONData:data receiver:receiver compiledGenome:genome options:0 error:NULL]);
+    XCTAssertEqualObjects(receiver[@"keyA"], @1);
+}
+
+- (void)testTransferTraitsFromJSONDataWithCommaDecimalLocale
+{
+    char *previousLocale = strdup(setlocale(LC_NUMERIC, NULL));
+    if (!setlocale(LC_NUMERIC, "de_DE.UTF-8") && !setlocale(LC_NUMERIC, "de_DE"))
+    {
+        free(previousLocale);
+        return;
+    }
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA")]];
+    NSMutableDictionary *receiver = [NSMutableDictionary dictionary];
+    BOOL transferred = [GNKLab transferTraitsFromJSONData:[@"{\"keyA\": 1.5}" dataUsingEncoding:NSUTF8StringEncoding] receiver:receiver compiledGenome:genome options:0 error:NULL];
+    
+    setlocale(LC_NUMERIC, previousLocale);
+    free(previousLocale);
+    
+    XCTAssertTrue(transferred);
+    XCTAssertEqualObjects(receiver[@"keyA"], @1.5);
+}
+
+- (void)testTransferTraitsFromJSONDataWithKeyPathThroughArray
+{
+    NSData *data = [@"{\"items\": [{\"id\": 1}, {\"id\": 2}, {}], \"user\": {\"tags\": [{\"name\": \"x\"}]}}" dataUsingEncoding:NSUTF8StringEncoding];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"items.id", @"ids"),
+                                                     GNKMakeGene(@"user.tags.name", @"tagNames"),
+                                                     GNKMakeGene(@"user.tags[0].name", @"firstTagName")]];
+    
+    NSMutableDictionary *streamedReceiver = [NSMutableDictionary dictionary];
+    XCTAssertTrue([GNKLab transferTraitsFromJSONData:data receiver:streamedReceiver compiledGenome:genome options:0 error:NULL]);
+    
+    NSMutableDictionary *parsedReceiver = [NSMutableDictionary dictionary];
+    [GNKLab transferTraitsFromSource:[NSJSONSerialization JSONObjectWithData:data options:0 error:NULL] receiver:parsedReceiver compiledGenome:genome options:0];
+    
+    XCTAssertEqualObjects(streamedReceiver, parsedReceiver);
+    XCTAssertEqualObjects(streamedReceiver[@"ids"], (@[@1, @2, [NSNull null]]));
+    XCTAssertEqualObjects(streamedReceiver[@"tagNames"], @[@"x"]);
+    XCTAssertEqualObjects(streamedReceiver[@"firstTagName"], @"x");
+}
+
+- (void)testTransferTraitsFromJSONDataWithInvalidNumbers
+{
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA")]];
+    NSMutableDictionary *receiver = [NSMutableDictionary dictionary];
+    
+    for (NSString *number in @[@"+5", @"01", @"1.", @"1-2", @"-", @".5", @"1e", @"1e+"])
+    {
+        NSArray *documents = @[[NSString stringWithFormat:@"{\"keyA\": %@}", number],
+                               [NSString stringWithFormat:@"{\"skipped\": [%@], \"keyA\": 1}", number]];
+        
+        for (NSString *JSON in documents)
+        {
+            NSData *data = [JSON dataUsingEncoding:NSUTF8StringEncoding];
+            XCTAssertNil([NSJSONSerialization JSONObjectWithData:data options:0 error:NULL], @"%@", JSON);
+            
+            NSError *error;
+            XCTAssertFalse([GNKLab transferTraitsFromJSONData:data receiver:receiver compiledGenome:genome options:0 error:&error], @"%@", JSON);
+            XCTAssertEqualObjects(error.domain, GNKLabErrorDomain);
+            XCTAssertEqual(receiver.count, 0);
+        }
+    }
+}
+
+- (void)testTransferTraitsFromJSONDataWithLongNumber
+{
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA"), GNKMakeGene(@"keyB")]];
+    NSString *number = [@"0." stringByPaddingToLength:80 withString:@"1234567890" startingAtIndex:0];
+    NSData *data = [[NSString stringWithFormat:@"{\"keyA\": %@, \"keyB\": -1.5e-3}", number] dataUsingEncoding:NSUTF8StringEncoding];
+    
+    NSMutableDictionary *streamedReceiver = [NSMutableDictionary dictionary];
+    NSMutableDictionary *parsedReceiver = [NSMutableDictionary dictionary];
+    
+    NSError *error;
+    XCTAssertTrue([GNKLab transferTraitsFromJSONData:data receiver:streamedReceiver compiledGenome:genome options:0 error:&error]);
+    XCTAssertNil(error);
+    
+    [GNKLab transferTraitsFromSource:[NSJSONSerialization JSONObjectWithData:data options:0 error:NULL] receiver:parsedReceiver compiledGenome:genome options:0];
+    
+    XCTAssertEqualObjects(streamedReceiver, parsedReceiver);
+    XCTAssertEqual(streamedReceiver.count, 2);
+}
+
+- (void)testTransferTraitsFromJSONDataWithUnmatchableGenome
+{
+    NSData *data = [@"{\"keyA\": \"A\", \"keyB\": \"B\"}" dataUsingEncoding:NSUTF8StringEncoding];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene([GNKTrait aggregateOfTraits:@[[GNKTrait traitWithKey:@"keyA"], [GNKTrait traitWithKey:@"keyB"]]], @"keyC")]];
+    
+    NSMutableDictionary *receiver = [NSMutableDictionary dictionary];
+    XCTAssertTrue([GNKLab transferTraitsFromJSONData:data receiver:receiver compiledGenome:genome options:0 error:nil]);
+    XCTAssertEqual([receiver[@"keyC"] count], 2);
+}
+
+- (void)testReceiversByTransferringTraitsFromJSONData
+{
+    NSData *data = [@"[{\"keyA\": \"A0\", \"keyB\": {\"nested\": [1]}}, {\"keyB\": \"B1\"}, {\"keyA\": \"A2\"}]" dataUsingEncoding:NSUTF8StringEncoding];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@selector(keyA))]];
+    
+    NSError *error;
+    NSArray *receivers = [GNKLab receiversByTransferringTraitsFromJSONData:data compiledGenome:genome options:0 receiverFactory:^id(NSUInteger index) {
+        return [GNKDummy new];
+    } error:&error];
+    
+    XCTAssertNil(error);
+    XCTAssertEqual(receivers.count, 3);
+    XCTAssertEqualObjects([receivers[0] keyA], @"A0");
+    XCTAssertNil([receivers[1] keyA]);
+    XCTAssertEqualObjects([receivers[2] keyA], @"A2");
+    
+    receivers = [GNKLab receiversByTransferringTraitsFromJSONData:[@"{\"keyA\": \"A\"}" dataUsingEncoding:NSUTF8StringEncoding] compiledGenome:genome options:0 receiverFactory:^id(NSUInteger index) {
+        return [GNKDummy new];
+    } error:&error];
+    
+    XCTAssertNil(receivers);
+    XCTAssertEqualObjects(error.domain, GNKLabErrorDomain);
+}
+
+- (void)testTransferTraitsWithEvaluateExpensiveGenesConcurrentlyOption
+{
+    NSDictionary *objA = @{@"keyA": @"a",
+                           @"keyB": @"b",
+                           @"keyC": [NSNull null]};
+    GNKOrderedDummy *objB = [GNKOrderedDummy new];
+    
+    GNKExpensiveUppercaseTransformer *transformer = [GNKExpensiveUppercaseTransformer new];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@selector(keyA), transformer),
+                                                     GNKMakeGene(@selector(keyB)),
+                                                     GNKMakeGene(@selector(keyC), transformer)]];
+    
+    [GNKLab transferTraitsFromSource:objA receiver:objB compiledGenome:genome options:GNKLabEvaluateExpensiveGenesConcurrently];
+    
+    XCTAssertEqualObjects(objB.keyA, @"A");
+    XCTAssertEqualObjects(objB.keyB, @"b");
+    XCTAssertNil(objB.keyC);
+    XCTAssertEqualObjects(objB.setKeys, (@[@"keyA", @"keyB", @"keyC"]));
+    XCTAssertEqualObjects(objB.setThreads, [NSSet setWithObject:[NSThread currentThread]]);
+}
+
+- (void)testTransferTraitsWithEvaluateExpensiveGenesConcurrentlyOptionRaisesOnCallingThread
+{
+    NSDictionary *objA = @{@"keyA": @"a",
+                           @"keyB": @"b",
+                           @"keyC": @"c"};
+    GNKOrderedDummy *objB = [GNKOrderedDummy new];
+    
+    GNKExpensiveThrowingTransformer *transformer = [GNKExpensiveThrowingTransformer new];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@selector(keyA), transformer),
+                                                     GNKMakeGene(@selector(keyB), [GNKExpensiveUppercaseTransformer new]),
+                                                     GNKMakeGene(@selector(keyC), transformer)]];
+    
+    XCTAssertThrowsSpecificNamed([GNKLab transferTraitsFromSource:objA receiver:objB compiledGenome:genome options:GNKLabEvaluateExpensiveGenesConcurrently], NSException, NSInternalInconsistencyException);
+    
+    // Expensive values are all evaluated before any are set, so nothing is set when one of them raises.
+    XCTAssertNil(objB.keyA);
+    XCTAssertNil(objB.keyB);
+    XCTAssertNil(objB.keyC);
+}
+
+- (void)testTransferTraitsWithSkipUnchangedValuesOption
+{
+    NSDictionary *objA = @{@"keyA": @"A",
+                           @"keyB": @"B",
+                           @"keyC": [NSNull null]};
+    
+    GNKBatchingDummy *objB = [GNKBatchingDummy new];
+    objB.keyA = @"A";
+    objB.setKeys = nil;
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@selector(keyA)),
+                                                     GNKMakeGene(@selector(keyB)),
+                                                     GNKMakeGene(@selector(keyC))]];
+    
+    [GNKLab transferTraitsFromSource:objA receiver:objB compiledGenome:genome options:GNKLabSkipUnchangedValues];
+    
+    XCTAssertEqualObjects(objB.setKeys, @[@"keyB"]);
+    XCTAssertEqualObjects(objB.keyB, @"B");
+    XCTAssertEqual(objB.willChangeCount, 1);
+    XCTAssertEqual(objB.didChangeCount, 1);
+    XCTAssertEqual(objB.setCountWhenWillChange, 0);
+    
+    [GNKLab transferTraitsFromSource:objA receiver:objB compiledGenome:genome options:GNKLabSkipUnchangedValues];
+    
+    XCTAssertEqualObjects(objB.setKeys, @[@"keyB"]);
+    XCTAssertEqual(objB.willChangeCount, 1);
+    XCTAssertEqual(objB.didChangeCount, 1);
+    
+    // Receivers are only told about batches of changes when unchanged values are skipped.
+    [GNKLab transferTraitsFromSource:objA receiver:objB compiledGenome:genome options:0];
+    
+    XCTAssertEqual(objB.setKeys.count, 4);
+    XCTAssertEqual(objB.willChangeCount, 1);
+}
+
+- (void)testTransferTraitsWithSkipUnchangedValuesOptionEndsBatchWhenRaising
+{
+    NSDictionary *objA = @{@"keyA": @"A",
+                           @"keyB": @"B"};
+    
+    GNKBatchingDummy *objB = [GNKBatchingDummy new];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@selector(keyA)),
+                                                     GNKMakeGene(@"keyB", @"missingKey")]];
+    
+    XCTAssertThrowsSpecificNamed([GNKLab transferTraitsFromSource:objA receiver:objB compiledGenome:genome options:GNKLabSkipUnchangedValues], NSException, NSUndefinedKeyException);
+    
+    XCTAssertEqualObjects(objB.keyA, @"A");
+    XCTAssertEqual(objB.willChangeCount, 1);
+    XCTAssertEqual(objB.didChangeCount, 1);
+}
+
+- (void)testInstrumentation
+{
+    GNKGene *geneA = GNKMakeGene(@selector(keyA), [GNKUppercaseTransformer new]);
+    GNKGene *geneB = GNKMakeGene(@selector(keyB));
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[geneA, geneB]];
+    
+    [GNKLab resetGeneStatistics];
+    [GNKLab transferTraitsFromSource:@{@"keyA": @"a"} receiver:[GNKDummy new] compiledGenome:genome options:0];
+    
+    XCTAssertEqual([GNKLab geneStatistics].count, 0);
+    
+    [GNKLab setInstrumentationEnabled:YES];
+    XCTAssertTrue([GNKLab isInstrumentationEnabled]);
+    
+    [GNKLab transferTraitsFromSource:@{@"keyA": @"a", @"keyB": [NSNull null]} receiver:[GNKDummy new] compiledGenome:genome options:0];
+    [GNKLab transferTraitsFromSource:@{@"keyA": @"a"} receiver:[GNKDummy new] compiledGenome:genome options:0];
+    
+    [GNKLab setInstrumentationEnabled:NO];
+    
+    NSArray *statistics = [GNKLab geneStatistics];
+    XCTAssertEqual(statistics.count, 2);
+    
+    for (GNKGeneStatistics *geneStatistics in statistics)
+    {
+        XCTAssertEqual(geneStatistics.transferCount, 2);
+        
+        if ([geneStatistics.gene isEqual:geneA])
+        {
+            XCTAssertEqual(geneStatistics.skippedCount, 0);
+            XCTAssertEqual(geneStatistics.nullCount, 0);
+            XCTAssertGreaterThan(geneStatistics.transformerTime, 0);
+        }
+        else
+        {
+            XCTAssertEqualObjects(geneStatistics.gene, geneB);
+            XCTAssertEqual(geneStatistics.skippedCount, 1);
+            XCTAssertEqual(geneStatistics.nullCount, 1);
+            XCTAssertEqual(geneStatistics.transformerTime, 0);
+        }
+    }
+    
+    [GNKLab resetGeneStatistics];
+    XCTAssertEqual([GNKLab geneStatistics].count, 0);
+}
+
 @end
 
 
 @implementation GNKDummy
 @end
 
+
+@implementation GNKMarkingLab
+
++ (void)transferTraitsFromSource:(id)source receiver:(id)receiver compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options
+{
+    [super transferTraitsFromSource:source receiver:receiver compiledGenome:genome options:options];
+    [receiver setKeyB:@"marked"];
+}
+
+@end
+
 @implementation GNKNilNullTransformer
 
 + (Class)transformedValueClass
@@ -266,3 +910,82 @@
 }
 
 @end
+
+@implementation GNKExpensiveUppercaseTransformer
+@end
+
+@implementation GNKExpensiveThrowingTransformer
+
+- (id)transformedValue:(id)value
+{
+    [NSException raise:NSInternalInconsistencyException format:@"Cannot transform %@", value];
+    return nil;
+}
+
+@end
+
+@implementation GNKOrderedDummy
+
+- (void)recordSetKey:(NSString *)key
+{
+    if (!self.setKeys)
+    {
+        self.setKeys = [NSMutableArray array];
+        self.setThreads = [NSMutableSet set];
+    }
+    
+    [self.setKeys addObject:key];
+    [self.setThreads addObject:[NSThread currentThread]];
+}
+
+- (void)setKeyA:(NSString *)keyA
+{
+    [super setKeyA:keyA];
+    [self recordSetKey:@"keyA"];
+}
+
+- (void)setKeyB:(NSString *)keyB
+{
+    [super setKeyB:keyB];
+    [self recordSetKey:@"keyB"];
+}
+
+- (void)setKeyC:(NSString *)keyC
+{
+    [super setKeyC:keyC];
+    [self recordSetKey:@"keyC"];
+}
+
+@end
+
+@implementation GNKBatchingDummy
+
+- (void)willChangeTraits
+{
+    self.willChangeCount++;
+    self.setCountWhenWillChange = self.setKeys.count;
+}
+
+- (void)didChangeTraits
+{
+    self.didChangeCount++;
+}
+
+@end
+
+@implementation GNKBatchUppercaseTransformer
+
+- (void)transformValues:(id __strong *)values count:(NSUInteger)count
+{
+    @synchronized(self)
+    {
+        self.batchCount++;
+    }
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        values[i] = [values[i] uppercaseString];
+    }
+}
+
+@end
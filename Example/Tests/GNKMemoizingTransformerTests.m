@@ -0,0 +1,171 @@
+//
+//  GNKMemoizingTransformerTests.m
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/26/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <GeneticsKit/GeneticsKit.h>
+
+@interface GNKCountingTransformer : NSValueTransformer
+
+@property (assign, nonatomic) NSUInteger transformCount;
+
+@end
+
+@implementation GNKCountingTransformer
+
+- (id)transformedValue:(id)value
+{
+    self.transformCount++;
+    return [value isKindOfClass:[NSString class]] ? [value uppercaseString] : nil;
+}
+
+@end
+
+@interface GNKMemoizingTransformerTests : XCTestCase
+
+@end
+
+@implementation GNKMemoizingTransformerTests
+
+- (void)testMemoization
+{
+    GNKCountingTransformer *countingTransformer = [GNKCountingTransformer new];
+    GNKMemoizingTransformer *transformer = [GNKMemoizingTransformer transformerWithValueTransformer:countingTransformer capacity:4];
+    
+    XCTAssertEqualObjects([transformer transformedValue:@"a"], @"A");
+    XCTAssertEqualObjects([transformer transformedValue:@"a"], @"A");
+    XCTAssertEqualObjects([transformer transformedValue:[@"a" mutableCopy]], @"A");
+    
+    XCTAssertEqual(countingTransformer.transformCount, 1);
+    XCTAssertEqual(transformer.hitCount, 2);
+    XCTAssertEqual(transformer.missCount, 1);
+}
+
+- (void)testNilValues
+{
+    GNKCountingTransformer *countingTransformer = [GNKCountingTransformer new];
+    GNKMemoizingTransformer *transformer = [GNKMemoizingTransformer transformerWithValueTransformer:countingTransformer capacity:4];
+    
+    XCTAssertNil([transformer transformedValue:nil]);
+    XCTAssertNil([transformer transformedValue:nil]);
+    XCTAssertNil([transformer transformedValue:[NSNull null]]);
+    XCTAssertNil([transformer transformedValue:@1]);
+    XCTAssertNil([transformer transformedValue:@1]);
+    
+    XCTAssertEqual(countingTransformer.transformCount, 3);
+    XCTAssertEqual(transformer.hitCount, 2);
+}
+
+- (void)testEviction
+{
+    GNKCountingTransformer *countingTransformer = [GNKCountingTransformer new];
+    GNKMemoizingTransformer *transformer = [GNKMemoizingTransformer transformerWithValueTransformer:countingTransformer capacity:2];
+    
+    [transformer transformedValue:@"a"];
+    [transformer transformedValue:@"b"];
+    
+    // Using "a" again makes "b" the least recently used input.
+    [transformer transformedValue:@"a"];
+    [transformer transformedValue:@"c"];
+    
+    XCTAssertEqual(countingTransformer.transformCount, 3);
+    
+    [transformer transformedValue:@"a"];
+    XCTAssertEqual(countingTransformer.transformCount, 3);
+    
+    [transformer transformedValue:@"b"];
+    XCTAssertEqual(countingTransformer.transformCount, 4);
+}
+
+- (void)testRemoveAllCachedValues
+{
+    GNKCountingTransformer *countingTransformer = [GNKCountingTransformer new];
+    GNKMemoizingTransformer *transformer = [GNKMemoizingTransformer transformerWithValueTransformer:countingTransformer capacity:2];
+    
+    [transformer transformedValue:@"a"];
+    [transformer transformedValue:@"a"];
+    [transformer removeAllCachedValues];
+    
+    XCTAssertEqual(transformer.hitCount, 0);
+    XCTAssertEqual(transformer.missCount, 0);
+    
+    [transformer transformedValue:@"a"];
+    XCTAssertEqual(countingTransformer.transformCount, 2);
+}
+
+- (void)testMutableInputs
+{
+    GNKCountingTransformer *countingTransformer = [GNKCountingTransformer new];
+    GNKMemoizingTransformer *transformer = [GNKMemoizingTransformer transformerWithValueTransformer:countingTransformer capacity:4];
+    
+    NSMutableString *input = [@"a" mutableCopy];
+    XCTAssertEqualObjects([transformer transformedValue:input], @"A");
+    
+    [input setString:@"b"];
+    
+    XCTAssertEqualObjects([transformer transformedValue:input], @"B");
+    XCTAssertEqualObjects([transformer transformedValue:@"a"], @"A");
+    XCTAssertEqual(countingTransformer.transformCount, 2);
+    XCTAssertEqual(transformer.hitCount, 1);
+}
+
+- (void)testRemoveManyCachedValues
+{
+    NSUInteger count = 100000;
+    GNKMemoizingTransformer *transformer = [GNKMemoizingTransformer transformerWithValueTransformer:[GNKCountingTransformer new] capacity:count];
+    
+    @autoreleasepool
+    {
+        for (NSUInteger i = 0; i < count; i++)
+        {
+            [transformer transformedValue:@(i)];
+        }
+    }
+    
+    // Releasing a long recency list must not recurse once per remembered value.
+    XCTAssertNoThrow([transformer removeAllCachedValues]);
+    
+    @autoreleasepool
+    {
+        for (NSUInteger i = 0; i < count; i++)
+        {
+            [transformer transformedValue:@(i)];
+        }
+    }
+    
+    transformer = nil;
+}
+
+- (void)testConcurrentTransforms
+{
+    GNKMemoizingTransformer *transformer = [GNKMemoizingTransformer transformerWithValueTransformer:[GNKCountingTransformer new] capacity:8];
+    
+    dispatch_apply(1000, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        NSString *value = [NSString stringWithFormat:@"value%zu", i % 16];
+        XCTAssertEqualObjects([transformer transformedValue:value], [value uppercaseString]);
+    });
+    
+    XCTAssertEqual(transformer.hitCount + transformer.missCount, 1000);
+}
+
+- (void)testTransfer
+{
+    GNKCountingTransformer *countingTransformer = [GNKCountingTransformer new];
+    GNKMemoizingTransformer *transformer = [GNKMemoizingTransformer transformerWithValueTransformer:countingTransformer capacity:4];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA", @"keyB", transformer)]];
+    
+    for (NSUInteger i = 0; i < 3; i++)
+    {
+        NSMutableDictionary *receiver = [NSMutableDictionary dictionary];
+        [GNKLab transferTraitsFromSource:@{@"keyA": @"a"} receiver:receiver compiledGenome:genome options:0];
+        XCTAssertEqualObjects(receiver[@"keyB"], @"A");
+    }
+    
+    XCTAssertEqual(countingTransformer.transformCount, 1);
+}
+
+@end
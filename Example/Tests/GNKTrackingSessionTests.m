@@ -0,0 +1,156 @@
+//
+//  GNKTrackingSessionTests.m
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/26/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <GeneticsKit/GeneticsKit.h>
+
+@interface GNKTrackingDummy : NSObject
+
+@property (copy, nonatomic) NSString *keyA;
+@property (copy, nonatomic) NSString *keyB;
+@property (strong, nonatomic) GNKTrackingDummy *child;
+
+@end
+
+@implementation GNKTrackingDummy
+@end
+
+@interface GNKTrackingSessionTests : XCTestCase
+
+@end
+
+@implementation GNKTrackingSessionTests
+
+- (void)testInitiallyDirty
+{
+    GNKTrackingDummy *source = [GNKTrackingDummy new];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA"), GNKMakeGene(@"keyB")]];
+    
+    GNKTrackingSession *session = [GNKTrackingSession sessionWithSource:source genome:genome];
+    
+    XCTAssertEqualObjects(session.dirtyGeneIndexes, [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)]);
+}
+
+- (void)testTransferClearsDirtyGenes
+{
+    GNKTrackingDummy *source = [GNKTrackingDummy new];
+    source.keyA = @"A";
+    source.keyB = @"B";
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA"), GNKMakeGene(@"keyB")]];
+    GNKTrackingSession *session = [GNKTrackingSession sessionWithSource:source genome:genome];
+    
+    NSMutableDictionary *receiver = [NSMutableDictionary dictionary];
+    [session transferTraitsToReceiver:receiver options:0];
+    
+    XCTAssertEqualObjects(receiver, (@{@"keyA": @"A", @"keyB": @"B"}));
+    XCTAssertEqual(session.dirtyGeneIndexes.count, 0);
+    
+    source.keyB = @"C";
+    
+    XCTAssertEqualObjects(session.dirtyGeneIndexes, [NSIndexSet indexSetWithIndex:1]);
+    
+    // Changes to the receiver are not tracked, so only the dirty gene is transfered.
+    receiver[@"keyA"] = @"Z";
+    [session transferTraitsToReceiver:receiver options:0];
+    
+    XCTAssertEqualObjects(receiver, (@{@"keyA": @"Z", @"keyB": @"C"}));
+    XCTAssertEqual(session.dirtyGeneIndexes.count, 0);
+}
+
+- (void)testDifferentTraits
+{
+    GNKTrackingDummy *source = [GNKTrackingDummy new];
+    source.keyA = @"A";
+    source.keyB = @"B";
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA"), GNKMakeGene(@"keyB")]];
+    GNKTrackingSession *session = [GNKTrackingSession sessionWithSource:source genome:genome];
+    
+    NSDictionary *receiver = @{@"keyA": @"A", @"keyB": @"X"};
+    
+    XCTAssertEqualObjects([session findGenesWithDifferentTraitsInReceiver:receiver options:0], [NSSet setWithObject:GNKMakeGene(@"keyB")]);
+    
+    // Equivalent genes are cleared while different genes stay dirty.
+    XCTAssertEqualObjects(session.dirtyGeneIndexes, [NSIndexSet indexSetWithIndex:1]);
+    
+    source.keyA = @"Y";
+    
+    XCTAssertEqualObjects([session indexesOfGenesWithDifferentTraitsInReceiver:receiver options:0], [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)]);
+}
+
+- (void)testKeyPathsAndSequences
+{
+    GNKTrackingDummy *source = [GNKTrackingDummy new];
+    source.child = [GNKTrackingDummy new];
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"child.keyA", @"keyA"),
+                                                     GNKMakeGene(@[@"child", @"keyB"], @"keyB")]];
+    GNKTrackingSession *session = [GNKTrackingSession sessionWithSource:source genome:genome];
+    
+    [session transferTraitsToReceiver:[NSMutableDictionary dictionary] options:0];
+    XCTAssertEqual(session.dirtyGeneIndexes.count, 0);
+    
+    source.child.keyB = @"B";
+    XCTAssertEqualObjects(session.dirtyGeneIndexes, [NSIndexSet indexSetWithIndex:1]);
+    
+    // Replacing an intermediate object affects every gene which passes through it.
+    source.child = [GNKTrackingDummy new];
+    XCTAssertEqualObjects(session.dirtyGeneIndexes, [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)]);
+}
+
+- (void)testUntrackedGenes
+{
+    GNKTrackingDummy *source = [GNKTrackingDummy new];
+    
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA"),
+                                                     GNKMakeGene([GNKTrait identityTrait], @"self")]];
+    GNKTrackingSession *session = [GNKTrackingSession sessionWithSource:source genome:genome];
+    
+    [session transferTraitsToReceiver:[NSMutableDictionary dictionary] options:0];
+    
+    XCTAssertEqualObjects(session.dirtyGeneIndexes, [NSIndexSet indexSetWithIndex:1]);
+}
+
+- (void)testInvalidate
+{
+    GNKTrackingDummy *source = [GNKTrackingDummy new];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA")]];
+    GNKTrackingSession *session = [GNKTrackingSession sessionWithSource:source genome:genome];
+    
+    [session transferTraitsToReceiver:[NSMutableDictionary dictionary] options:0];
+    [session invalidate];
+    
+    XCTAssertEqual(session.dirtyGeneIndexes.count, 1);
+    
+    [session transferTraitsToReceiver:[NSMutableDictionary dictionary] options:0];
+    
+    XCTAssertEqual(session.dirtyGeneIndexes.count, 1);
+}
+
+- (void)testConcurrentInvalidate
+{
+    GNKTrackingDummy *source = [GNKTrackingDummy new];
+    GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"keyA"), GNKMakeGene(@"child.keyB")]];
+    GNKTrackingSession *session = [GNKTrackingSession sessionWithSource:source genome:genome];
+    
+    [session transferTraitsToReceiver:[NSMutableDictionary dictionary] options:0];
+    
+    // Removing an observer twice raises, so only one of these may remove them.
+    XCTAssertNoThrow(dispatch_apply(16, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        [session invalidate];
+    }));
+    
+    XCTAssertEqualObjects(session.dirtyGeneIndexes, [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)]);
+    
+    source.keyA = @"A";
+    
+    XCTAssertEqualObjects(session.dirtyGeneIndexes, [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)]);
+}
+
+@end
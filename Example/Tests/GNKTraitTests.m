@@ -9,8 +9,23 @@
 #import <XCTest/XCTest.h>
 #import <GeneticsKit/GeneticsKit.h>
 
+@interface GNKTraitDummy : NSObject
+{
+    NSString *_hiddenKey;
+}
+@property (copy, nonatomic) NSString *keyA;
+@property (strong, nonatomic) GNKTraitDummy *child;
+@end
+
+@interface GNKTraitProxy : NSProxy
+- (instancetype)initWithTarget:(id)target;
+@property (strong, nonatomic, readonly) id target;
+@end
+
 @interface GNKTraitTests : XCTestCase
 
+@property (strong, nonatomic) NSMutableArray *observedValues;
+
 @end
 
 @implementation GNKTraitTests
@@ -63,6 +78,45 @@
     XCTAssertEqualObjects(object[2], @2);
 }
 
+- (void)testIndexTraitSettingSparse
+{
+    NSMutableArray *object = [NSMutableArray arrayWithObject:@0];
+    
+    id trait = [GNKTrait traitWithIndex:500];
+    [trait setTraitValue:@500 onObject:object];
+    
+    XCTAssertEqual(object.count, 501);
+    XCTAssertEqualObjects(object[0], @0);
+    XCTAssertEqualObjects(object[1], [NSNull null]);
+    XCTAssertEqualObjects(object[499], [NSNull null]);
+    XCTAssertEqualObjects([trait traitValueFromObject:object], @500);
+    
+    [trait setTraitValue:@"replaced" onObject:object];
+    
+    XCTAssertEqual(object.count, 501);
+    XCTAssertEqualObjects([trait traitValueFromObject:object], @"replaced");
+    XCTAssertNil([[GNKTrait traitWithIndex:501] traitValueFromObject:object]);
+}
+
+- (void)testIndexTraitGettingSettingThroughProxy
+{
+    NSMutableArray *array = [NSMutableArray arrayWithObjects:@0, @1, nil];
+    id proxy = [[GNKTraitProxy alloc] initWithTarget:array];
+    
+    id trait = [GNKTrait traitWithIndex:1];
+    
+    XCTAssertEqualObjects([trait traitValueFromObject:array], @1);
+    XCTAssertEqualObjects([trait traitValueFromObject:proxy], @1);
+    
+    trait = [GNKTrait traitWithIndex:3];
+    [trait setTraitValue:@3 onObject:proxy];
+    
+    XCTAssertEqual(array.count, 4);
+    XCTAssertEqualObjects(array[2], [NSNull null]);
+    XCTAssertEqualObjects([trait traitValueFromObject:proxy], @3);
+    XCTAssertNil([[GNKTrait traitWithIndex:4] traitValueFromObject:[[GNKTraitProxy alloc] initWithTarget:@[]]]);
+}
+
 
 #pragma mark - Key trait
 
@@ -112,6 +166,102 @@
 }
 
 
+- (void)testKeyTraitGettingSettingOnObject
+{
+    GNKTraitDummy *object = [GNKTraitDummy new];
+    
+    id trait = [GNKTrait traitWithKey:@"keyA"];
+    
+    XCTAssertNil([trait traitValueFromObject:object]);
+    
+    [trait setTraitValue:@"A" onObject:object];
+    
+    XCTAssertEqualObjects(object.keyA, @"A");
+    XCTAssertEqualObjects([trait traitValueFromObject:object], @"A");
+    
+    // The same trait must keep working when alternating between classes.
+    NSDictionary *dictionary = @{@"keyA": @"B"};
+    XCTAssertEqualObjects([trait traitValueFromObject:dictionary], @"B");
+    XCTAssertEqualObjects([trait traitValueFromObject:object], @"A");
+    
+    trait = [GNKTrait traitWithKey:@"hiddenKey"];
+    
+    [trait setTraitValue:@"H" onObject:object];
+    
+    XCTAssertEqualObjects([trait traitValueFromObject:object], @"H");
+    XCTAssertEqualObjects([object valueForKey:@"hiddenKey"], @"H");
+}
+
+- (void)testKeyTraitGettingConcurrently
+{
+    GNKTraitDummy *object = [GNKTraitDummy new];
+    object.keyA = @"A";
+    NSDictionary *dictionary = @{@"keyA": @"B"};
+    
+    id trait = [GNKTrait traitWithKey:@"keyA"];
+    
+    dispatch_apply(1000, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        if (i % 2)
+        {
+            XCTAssertEqualObjects([trait traitValueFromObject:object], @"A");
+        }
+        else
+        {
+            XCTAssertEqualObjects([trait traitValueFromObject:dictionary], @"B");
+        }
+    });
+}
+
+- (void)testKeyPathTraitGettingSetting
+{
+    GNKTraitDummy *object = [GNKTraitDummy new];
+    object.child = [GNKTraitDummy new];
+    
+    id trait = [GNKTrait traitWithKey:@"child.keyA"];
+    
+    XCTAssertEqualObjects(trait, [GNKTrait traitWithKey:@"child.keyA"]);
+    XCTAssertEqual([trait hash], [[GNKTrait traitWithKey:@"child.keyA"] hash]);
+    XCTAssertNil([trait traitValueFromObject:object]);
+    
+    [trait setTraitValue:@"A" onObject:object];
+    
+    XCTAssertEqualObjects(object.child.keyA, @"A");
+    XCTAssertEqualObjects([trait traitValueFromObject:object], @"A");
+    
+    NSDictionary *dictionary = @{@"child": @{@"keyA": @"B"}};
+    XCTAssertEqualObjects([trait traitValueFromObject:dictionary], @"B");
+    
+    object.child = nil;
+    XCTAssertNil([trait traitValueFromObject:object]);
+    XCTAssertNoThrow([trait setTraitValue:@"C" onObject:object]);
+    
+    trait = [GNKTrait traitWithKey:@"child.@count"];
+    XCTAssertEqualObjects([trait traitValueFromObject:@{@"child": @[@1, @2]}], @2);
+}
+
+- (void)testKeyTraitGettingSettingOnObservedObject
+{
+    GNKTraitDummy *object = [GNKTraitDummy new];
+    id trait = [GNKTrait traitWithKey:@"keyA"];
+    
+    [trait setTraitValue:@"A" onObject:object];
+    
+    self.observedValues = [NSMutableArray array];
+    [object addObserver:self forKeyPath:@"keyA" options:NSKeyValueObservingOptionNew context:NULL];
+    
+    [trait setTraitValue:@"B" onObject:object];
+    
+    [object removeObserver:self forKeyPath:@"keyA"];
+    
+    XCTAssertEqualObjects(self.observedValues, @[@"B"]);
+    XCTAssertEqualObjects([trait traitValueFromObject:object], @"B");
+}
+
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context
+{
+    [self.observedValues addObject:change[NSKeyValueChangeNewKey]];
+}
+
 #pragma mark - Sequence trait
 
 - (void)testSequenceTraitInit
@@ -161,6 +311,23 @@
 }
 
 
+- (void)testNestedSequenceTrait
+{
+    id nestedTrait = [GNKTrait sequenceOfTraits:@[[GNKTrait sequenceOfTraits:@[[GNKTrait traitWithKey:@"keyA"], [GNKTrait traitWithIndex:1]]],
+                                                  [GNKTrait traitWithKey:@"keyB"]]];
+    id flatTrait = [GNKTrait sequenceOfTraits:@[[GNKTrait traitWithKey:@"keyA"], [GNKTrait traitWithIndex:1], [GNKTrait traitWithKey:@"keyB"]]];
+    
+    XCTAssertEqualObjects(nestedTrait, flatTrait);
+    XCTAssertEqualObjects([@[@"keyA[1]", @"keyB"] GNKReceivingTraitValue], flatTrait);
+    
+    NSMutableDictionary *object = [NSMutableDictionary dictionaryWithObject:[NSMutableArray arrayWithObjects:[NSNull null], [NSMutableDictionary dictionary], nil] forKey:@"keyA"];
+    
+    [nestedTrait setTraitValue:@"B" onObject:object];
+    
+    XCTAssertEqualObjects(object[@"keyA"][1][@"keyB"], @"B");
+    XCTAssertEqualObjects([nestedTrait traitValueFromObject:object], @"B");
+}
+
 #pragma mark - Aggregate trait
 
 - (void)testAggregateTraitInit
@@ -208,6 +375,35 @@
     XCTAssertEqualObjects([trait traitValueFromObject:object], expected);
 }
 
+- (void)testAggregateTraitGettingManyTraits
+{
+    NSDictionary *object = @{@"keyA": @"A", @"keyC": @"C", @"keyE": @"E", @"keyF": @"F"};
+    
+    NSArray *keys = @[@"keyA", @"keyB", @"keyC", @"keyD", @"keyE", @"keyF"];
+    NSMutableArray *traits = [NSMutableArray array];
+    for (NSString *key in keys)
+    {
+        [traits addObject:[GNKTrait traitWithKey:key]];
+    }
+    
+    id trait = [GNKTrait aggregateOfTraits:traits];
+    NSDictionary *traitValue = [trait traitValueFromObject:object];
+    
+    XCTAssertEqual(traitValue.count, 4);
+    XCTAssertEqualObjects(traitValue[[GNKTrait traitWithKey:@"keyE"]], @"E");
+    XCTAssertNil(traitValue[[GNKTrait traitWithKey:@"keyB"]]);
+    XCTAssertNil(traitValue[[GNKTrait traitWithKey:@"keyZ"]]);
+    
+    NSMutableSet *enumeratedTraits = [NSMutableSet set];
+    for (id enumeratedTrait in traitValue)
+    {
+        [enumeratedTraits addObject:enumeratedTrait];
+    }
+    
+    XCTAssertEqualObjects(enumeratedTraits, [NSSet setWithArray:traitValue.allKeys]);
+    XCTAssertEqual(enumeratedTraits.count, 4);
+}
+
 
 #pragma mark - Identity trait
 
@@ -245,6 +441,29 @@
 }
 
 
+#pragma mark - Interning
+
+- (void)testInterning
+{
+    id uninternedTrait = [GNKTrait sequenceOfTraits:@[[GNKTrait traitWithKey:@"keyA"], [GNKTrait traitWithIndex:0]]];
+    
+    [GNKTrait setInterningEnabled:YES];
+    
+    id traitA = [GNKTrait sequenceOfTraits:@[[GNKTrait traitWithKey:@"keyA"], [GNKTrait traitWithIndex:0]]];
+    id traitB = [GNKTrait sequenceOfTraits:@[[GNKTrait traitWithKey:@"keyA"], [GNKTrait traitWithIndex:0]]];
+    id traitC = [GNKTrait sequenceOfTraits:@[[GNKTrait traitWithKey:@"keyA"], [GNKTrait traitWithIndex:1]]];
+    
+    [GNKTrait setInterningEnabled:NO];
+    
+    XCTAssertEqual(traitA, traitB);
+    XCTAssertNotEqual(traitA, traitC);
+    XCTAssertFalse([traitA isEqual:traitC]);
+    
+    XCTAssertEqualObjects(uninternedTrait, traitA);
+    XCTAssertEqual([uninternedTrait hash], [traitA hash]);
+}
+
+
 #pragma mark - Conversions
 
 - (void)testStringSingleTrait
@@ -284,6 +503,25 @@
     XCTAssertNil(trait);
 }
 
+- (void)testStringTraitReuse
+{
+    NSMutableString *string = [NSMutableString stringWithString:@"keyA[0].keyB"];
+    id trait = [string GNKReceivingTraitValue];
+    
+    XCTAssertEqual([@"keyA[0].keyB" GNKReceivingTraitValue], trait);
+    
+    [string appendString:@".keyC"];
+    
+    id expected = [GNKTrait sequenceOfTraits:@[[GNKTrait traitWithKey:@"keyA"],
+                                               [GNKTrait traitWithIndex:0],
+                                               [GNKTrait traitWithKey:@"keyB"],
+                                               [GNKTrait traitWithKey:@"keyC"]]];
+    
+    XCTAssertEqualObjects([string GNKReceivingTraitValue], expected);
+    XCTAssertNil([@"keyA[]" GNKReceivingTraitValue]);
+    XCTAssertNil([@"keyA[]" GNKReceivingTraitValue]);
+}
+
 - (void)testNumberTrait
 {
     id trait = [@9 GNKReceivingTraitValue];
@@ -354,4 +592,29 @@
 
 
 
+@end
+
+
+@implementation GNKTraitDummy
+@end
+
+
+@implementation GNKTraitProxy
+
+- (instancetype)initWithTarget:(id)target
+{
+    _target = target;
+    return self;
+}
+
+- (NSMethodSignature *)methodSignatureForSelector:(SEL)sel
+{
+    return [self.target methodSignatureForSelector:sel];
+}
+
+- (void)forwardInvocation:(NSInvocation *)invocation
+{
+    [invocation invokeWithTarget:self.target];
+}
+
 @end
@@ -0,0 +1,28 @@
+//
+//  GNKBatchValueTransformer.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/27/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  Protocol which NSValueTransformer subclasses may adopt to transform many values in a single call.
+ *
+ *  When a gene's transformer conforms to this protocol, GNKLab methods which transfer traits between many pairs of objects gather the gene's source values for a group of objects, transform them together, then set each result on its receiver. Transformers which can convert a whole column of values faster than one value at a time, for example by unboxing numbers into a contiguous buffer, should adopt this protocol.
+ *
+ *  Transferring traits between a single pair of objects still uses -transformedValue:, so conforming transformers must implement both with the same results.
+ */
+@protocol GNKBatchValueTransformer <NSObject>
+
+/**
+ *  Transforms each value in the buffer in place, exactly as if -transformedValue: had been called with each of them.
+ *
+ *  @param values A buffer of values to transform. Any value may be nil, and each may be replaced with nil. Replaced values are released by the buffer.
+ *  @param count  The number of values in the buffer. This is always greater than 0.
+ */
+- (void)transformValues:(id __strong *)values count:(NSUInteger)count;
+
+@end
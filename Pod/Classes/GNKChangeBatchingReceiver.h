@@ -0,0 +1,28 @@
+//
+//  GNKChangeBatchingReceiver.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/28/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  Protocol which receiving objects may adopt to be told when a transfer begins and ends changing their traits, so they can coalesce the work each change would otherwise trigger, such as posting notifications or recomputing derived values.
+ *
+ *  The methods are only called when the GNKLabSkipUnchangedValues option is passed. During a single transfer, -willChangeTraits is called immediately before the first value which differs is set, and -didChangeTraits is called once every gene has been transfered. Neither is called if no value differs.
+ */
+@protocol GNKChangeBatchingReceiver <NSObject>
+
+/**
+ *  Called before the first changed value is set on the receiver during a transfer.
+ */
+- (void)willChangeTraits;
+
+/**
+ *  Called after the last changed value is set on the receiver during a transfer.
+ */
+- (void)didChangeTraits;
+
+@end
@@ -0,0 +1,20 @@
+//
+//  GNKExpensiveValueTransformer.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/28/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  Protocol which NSValueTransformer subclasses may adopt to mark themselves as expensive enough to be worth running on another thread.
+ *
+ *  When the GNKLabEvaluateExpensiveGenesConcurrently option is passed, GNKLab methods which transfer traits between a single pair of objects retrieve and transform the source values of every gene whose transformer conforms to this protocol concurrently, before setting any value on the receiver. Transformers which do real work for each value, such as decoding image metadata or normalizing text with regular expressions, should adopt this protocol.
+ *
+ *  Conforming transformers must be safe to call from many threads at once.
+ */
+@protocol GNKExpensiveValueTransformer <NSObject>
+
+@end
@@ -87,6 +87,8 @@
 /**
  *  Creates an inverted gene from the receiver by swapping the source and receiving traits and reversing the transformer if set.
  *
+ *  The inverted gene is created the first time this method is called, and the same instance is returned by every later call. Inverting an inverted gene returns a gene equal to the original.
+ *
  *  @note This method will return nil if the receiver cannot be inverted.
  *
  *  @see canInvertGene
@@ -110,7 +112,24 @@
 #define GNK_GENE_2(ARG1, ARG2, ...) GNKGeneFromArgs(GNK_OBJ_CONVERT(ARG1), GNK_OBJ_CONVERT(ARG2), nil)
 #define GNK_GENE_3(ARG1, ARG2, ARG3, ...) GNKGeneFromArgs(GNK_OBJ_CONVERT(ARG1), GNK_OBJ_CONVERT(ARG2), GNK_OBJ_CONVERT(ARG3))
 
-#define GNK_OBJ_CONVERT(VAL) GNKGeneConvertToObject(@encode(__typeof__((VAL))), (VAL))
+#define GNK_OBJ_CONVERT(VAL) GNKGeneBox((VAL))
 
 FOUNDATION_EXPORT GNKGene *GNKGeneFromArgs(id arg1, id arg2, id arg3) __attribute((nonnull (1)));
+
+/**
+ *  Boxes an argument to GNKMakeGene. The overload is chosen at compile time from the type of the argument, so boxing costs no more than the conversion itself. Selectors are boxed as their names and numbers are boxed as NSNumber objects. Smaller integer and floating point types are promoted to one of the types below.
+ */
+static inline __attribute((overloadable)) id GNKGeneBox(id object) { return object; }
+static inline __attribute((overloadable)) id GNKGeneBox(SEL selector) { return NSStringFromSelector(selector); }
+static inline __attribute((overloadable)) id GNKGeneBox(int value) { return @(value); }
+static inline __attribute((overloadable)) id GNKGeneBox(long value) { return @(value); }
+static inline __attribute((overloadable)) id GNKGeneBox(long long value) { return @(value); }
+static inline __attribute((overloadable)) id GNKGeneBox(unsigned int value) { return @(value); }
+static inline __attribute((overloadable)) id GNKGeneBox(unsigned long value) { return @(value); }
+static inline __attribute((overloadable)) id GNKGeneBox(unsigned long long value) { return @(value); }
+static inline __attribute((overloadable)) id GNKGeneBox(double value) { return @(value); }
+
+/**
+ *  Boxes a variadic argument described by its type encoding. GNKMakeGene no longer uses this function, since GNKGeneBox boxes arguments at compile time, but it remains for code which calls it directly.
+ */
 FOUNDATION_EXPORT id GNKGeneConvertToObject(const char *type, ...);
\ No newline at end of file
@@ -6,8 +6,10 @@
 //  Copyright (c) 2015 Zach Radke. All rights reserved.
 //
 
-#import "GNKGene.h"
+#import "GNKGene_Private.h"
 #import "GNKTrait.h"
+#import <objc/runtime.h>
+#import <pthread.h>
 
 
 @interface _GNKInvertedTransformer : NSValueTransformer
@@ -19,7 +21,21 @@
 @end
 
 
+typedef NS_ENUM(char, _GNKGeneInvertibility)
+{
+    _GNKGeneInvertibilityUnresolved = 0,
+    _GNKGeneInvertibilityInvertible,
+    _GNKGeneInvertibilityNotInvertible
+};
+
 @implementation GNKGene
+{
+    NSUInteger _hash;
+    
+    // Genes are immutable, so whether they can be inverted and their inverted gene are each resolved once.
+    volatile _GNKGeneInvertibility _invertibility;
+    GNKGene *_invertedGene;
+}
 
 #pragma mark - API
 
@@ -39,6 +55,9 @@
     _receivingTrait = [(id)receivingTrait copy];
     _transformer = transformer;
     
+    // Genes are immutable, so their hash can be computed once.
+    _hash = ((([_sourceTrait hash] * 31) + [_receivingTrait hash]) * 31) + [_transformer hash];
+    
     return self;
 }
 
@@ -67,8 +86,16 @@
 
 - (BOOL)canInvertGene
 {
-    return [self.sourceTrait conformsToProtocol:@protocol(GNKReceivingTrait)] &&
-           (!self.transformer || [[self.transformer class] allowsReverseTransformation]);
+    // Resolving twice on different threads is harmless, since both resolve the same answer.
+    if (_invertibility == _GNKGeneInvertibilityUnresolved)
+    {
+        BOOL canInvert = [self.sourceTrait conformsToProtocol:@protocol(GNKReceivingTrait)] &&
+                         (!self.transformer || [[self.transformer class] allowsReverseTransformation]);
+        
+        _invertibility = canInvert ? _GNKGeneInvertibilityInvertible : _GNKGeneInvertibilityNotInvertible;
+    }
+    
+    return _invertibility == _GNKGeneInvertibilityInvertible;
 }
 
 - (instancetype)invertedGene
@@ -78,8 +105,23 @@
         return nil;
     }
     
-    NSValueTransformer *transformer = (self.transformer) ? [[_GNKInvertedTransformer alloc] initWithValueTransformer:self.transformer] : nil;
-    return [[[self class] alloc] initWithSourceTrait:self.receivingTrait receivingTrait:self.sourceTrait transformer:transformer];
+    @synchronized(self)
+    {
+        if (_invertedGene)
+        {
+            return _invertedGene;
+        }
+        
+        // Inverting an inverted transformer unwraps it rather than wrapping it again.
+        NSValueTransformer *transformer = GNKGeneReversedTransformer(self.transformer);
+        if (!transformer && self.transformer)
+        {
+            transformer = [[_GNKInvertedTransformer alloc] initWithValueTransformer:self.transformer];
+        }
+        
+        _invertedGene = [[[self class] alloc] initWithSourceTrait:self.receivingTrait receivingTrait:self.sourceTrait transformer:transformer];
+        return _invertedGene;
+    }
 }
 
 #pragma mark - NSObject
@@ -101,7 +143,7 @@
     {
         return YES;
     }
-    else if (![object isKindOfClass:[self class]])
+    else if (![object isKindOfClass:[self class]] || self.hash != [object hash])
     {
         return NO;
     }
@@ -111,7 +153,7 @@
 
 - (NSUInteger)hash
 {
-    return [self.sourceTrait hash] ^ [self.receivingTrait hash] ^ [self.transformer hash];
+    return _hash;
 }
 
 
@@ -163,6 +205,130 @@
 @end
 
 
+NSValueTransformer *GNKGeneReversedTransformer(NSValueTransformer *transformer)
+{
+    return [transformer isMemberOfClass:[_GNKInvertedTransformer class]] ? [(_GNKInvertedTransformer *)transformer transformer] : nil;
+}
+
+
+typedef NS_OPTIONS(NSUInteger, _GNKGeneArgCapabilities)
+{
+    _GNKGeneArgCapabilityResolved = 1 << 0,
+    _GNKGeneArgCapabilitySourceTrait = 1 << 1,
+    _GNKGeneArgCapabilitySourceTraitConvertible = 1 << 2,
+    _GNKGeneArgCapabilityReceivingTrait = 1 << 3,
+    _GNKGeneArgCapabilityReceivingTraitConvertible = 1 << 4,
+    _GNKGeneArgCapabilityTransformer = 1 << 5
+};
+
+static _GNKGeneArgCapabilities GNKResolveGeneArgCapabilities(id arg)
+{
+    _GNKGeneArgCapabilities capabilities = _GNKGeneArgCapabilityResolved;
+    
+    if ([arg conformsToProtocol:@protocol(GNKSourceTrait)])
+    {
+        capabilities |= _GNKGeneArgCapabilitySourceTrait;
+    }
+    
+    if ([arg conformsToProtocol:@protocol(GNKSourceTraitConvertible)])
+    {
+        capabilities |= _GNKGeneArgCapabilitySourceTraitConvertible;
+    }
+    
+    if ([arg conformsToProtocol:@protocol(GNKReceivingTrait)])
+    {
+        capabilities |= _GNKGeneArgCapabilityReceivingTrait;
+    }
+    
+    if ([arg conformsToProtocol:@protocol(GNKReceivingTraitConvertible)])
+    {
+        capabilities |= _GNKGeneArgCapabilityReceivingTraitConvertible;
+    }
+    
+    if ([arg isKindOfClass:[NSValueTransformer class]])
+    {
+        capabilities |= _GNKGeneArgCapabilityTransformer;
+    }
+    
+    return capabilities;
+}
+
+/**
+ *  The conformance resolved for a single class. Records are never deallocated once resolved, so they can be cached without retaining them.
+ */
+typedef struct
+{
+    Class argClass;
+    _GNKGeneArgCapabilities capabilities;
+    
+    /**
+     *  YES for proxies, which answer for their targets, and for classes which override -conformsToProtocol:, in which case conformance is resolved for each argument.
+     */
+    BOOL resolvesPerArg;
+} _GNKGeneArgCapabilitiesRecord;
+
+/**
+ *  Returns the record for the argument's class, resolving it from the argument the first time the class is seen.
+ */
+static const _GNKGeneArgCapabilitiesRecord *GNKGeneArgCapabilitiesRecordForArg(id arg)
+{
+    static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    static NSMapTable *recordsForClasses;
+    
+    Class argClass = object_getClass(arg);
+    
+    pthread_mutex_lock(&lock);
+    
+    if (!recordsForClasses)
+    {
+        recordsForClasses = [NSMapTable mapTableWithKeyOptions:(NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality)
+                                                  valueOptions:(NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality)];
+    }
+    
+    _GNKGeneArgCapabilitiesRecord *record = (__bridge void *)[recordsForClasses objectForKey:argClass];
+    
+    if (!record)
+    {
+        record = malloc(sizeof(_GNKGeneArgCapabilitiesRecord));
+        record->argClass = argClass;
+        record->resolvesPerArg = [arg isProxy] || class_getMethodImplementation(argClass, @selector(conformsToProtocol:)) != class_getMethodImplementation([NSObject class], @selector(conformsToProtocol:));
+        record->capabilities = record->resolvesPerArg ? 0 : GNKResolveGeneArgCapabilities(arg);
+        
+        [recordsForClasses setObject:(__bridge id)(void *)record forKey:argClass];
+    }
+    
+    pthread_mutex_unlock(&lock);
+    
+    return record;
+}
+
+/**
+ *  Returns which protocols a gene argument conforms to. Records for recently seen classes are kept in a small table indexed by class, which is read without locking, so repeated argument classes are checked without sending any -conformsToProtocol: messages.
+ */
+static _GNKGeneArgCapabilities GNKGeneArgCapabilities(id arg)
+{
+    // Gene arguments usually alternate between a few classes, like strings and transformers, so a single last-class slot would keep missing.
+    enum { _GNKGeneArgCapabilitiesSlotCount = 16 };
+    static const _GNKGeneArgCapabilitiesRecord *recentRecords[_GNKGeneArgCapabilitiesSlotCount];
+    
+    if (!arg)
+    {
+        return 0;
+    }
+    
+    Class argClass = object_getClass(arg);
+    const _GNKGeneArgCapabilitiesRecord **slot = &recentRecords[((uintptr_t)argClass >> 4) % _GNKGeneArgCapabilitiesSlotCount];
+    const _GNKGeneArgCapabilitiesRecord *record = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    
+    if (!record || record->argClass != argClass)
+    {
+        record = GNKGeneArgCapabilitiesRecordForArg(arg);
+        __atomic_store_n(slot, record, __ATOMIC_RELEASE);
+    }
+    
+    return record->resolvesPerArg ? GNKResolveGeneArgCapabilities(arg) : record->capabilities;
+}
+
 static void GNKPopulateGeneArgs(id arg, id __autoreleasing *sourceTrait, id __autoreleasing *receivingTrait, NSValueTransformer *__autoreleasing *transformer)
 {
     NSCParameterAssert(sourceTrait);
@@ -174,14 +340,16 @@ static void GNKPopulateGeneArgs(id arg, id __autoreleasing *sourceTrait, id __au
         return;
     }
     
+    _GNKGeneArgCapabilities capabilities = GNKGeneArgCapabilities(arg);
+    
     if (!(*sourceTrait))
     {
-        if ([arg conformsToProtocol:@protocol(GNKSourceTrait)])
+        if (capabilities & _GNKGeneArgCapabilitySourceTrait)
         {
             *sourceTrait = arg;
             return;
         }
-        else if ([arg conformsToProtocol:@protocol(GNKSourceTraitConvertible)])
+        else if (capabilities & _GNKGeneArgCapabilitySourceTraitConvertible)
         {
             *sourceTrait = [arg GNKSourceTraitValue];
             return;
@@ -190,19 +358,19 @@ static void GNKPopulateGeneArgs(id arg, id __autoreleasing *sourceTrait, id __au
     
     if (!(*receivingTrait))
     {
-        if ([arg conformsToProtocol:@protocol(GNKReceivingTrait)])
+        if (capabilities & _GNKGeneArgCapabilityReceivingTrait)
         {
             *receivingTrait = arg;
             return;
         }
-        else if ([arg conformsToProtocol:@protocol(GNKReceivingTraitConvertible)])
+        else if (capabilities & _GNKGeneArgCapabilityReceivingTraitConvertible)
         {
             *receivingTrait = [arg GNKReceivingTraitValue];
             return;
         }
     }
     
-    if (!(*transformer) && [arg isKindOfClass:[NSValueTransformer class]])
+    if (!(*transformer) && (capabilities & _GNKGeneArgCapabilityTransformer))
     {
         *transformer = arg;
     }
@@ -223,7 +391,7 @@ GNKGene *GNKGeneFromArgs(id arg1, id arg2, id arg3)
     GNKPopulateGeneArgs(arg2, &sourceTrait, &receivingTrait, &transformer);
     GNKPopulateGeneArgs(arg3, &sourceTrait, &receivingTrait, &transformer);
     
-    if (!receivingTrait && [sourceTrait conformsToProtocol:@protocol(GNKReceivingTrait)])
+    if (!receivingTrait && (GNKGeneArgCapabilities(sourceTrait) & _GNKGeneArgCapabilityReceivingTrait))
     {
         receivingTrait = sourceTrait;
     }
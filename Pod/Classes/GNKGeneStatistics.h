@@ -0,0 +1,71 @@
+//
+//  GNKGeneStatistics.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/28/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class GNKGene;
+
+/**
+ *  A GNKGeneStatistics is an immutable snapshot of the work GNKLab performed for a single gene while instrumentation was enabled. Snapshots are created by +[GNKLab geneStatistics], which combines the counters recorded by every thread.
+ *
+ *  Genes are combined by equality, so the statistics for a gene include every transfer of an equivalent gene, regardless of which genome it belonged to.
+ *
+ *  @see +[GNKLab setInstrumentationEnabled:]
+ */
+@interface GNKGeneStatistics : NSObject
+
+/**
+ *  Initializes the receiver with the counters recorded for a gene. This is the designated initializer.
+ *
+ *  @param gene            The gene the counters were recorded for. This must not be nil.
+ *  @param transferCount   The number of times the gene was transfered.
+ *  @param skippedCount    The number of transfers which were skipped because the value was `nil`, or was unchanged when GNKLabSkipUnchangedValues was passed.
+ *  @param nullCount       The number of transfers whose source value was `[NSNull null]`.
+ *  @param transformerTime The total time spent in the gene's transformer, in seconds.
+ *  @param setterTime      The total time spent setting values with the gene's receiving trait, in seconds.
+ *
+ *  @return An initialized instance of the receiver.
+ */
+- (instancetype)initWithGene:(GNKGene *)gene
+               transferCount:(NSUInteger)transferCount
+                skippedCount:(NSUInteger)skippedCount
+                   nullCount:(NSUInteger)nullCount
+             transformerTime:(NSTimeInterval)transformerTime
+                  setterTime:(NSTimeInterval)setterTime NS_DESIGNATED_INITIALIZER __attribute((nonnull (1)));
+
+/**
+ *  The gene the statistics were recorded for.
+ */
+@property (strong, nonatomic, readonly) GNKGene *gene;
+
+/**
+ *  The number of times the gene was transfered from a source to a receiver, including transfers which were skipped.
+ */
+@property (assign, nonatomic, readonly) NSUInteger transferCount;
+
+/**
+ *  The number of transfers which set nothing on the receiver because the value was `nil` and GNKLabUseNilValues was not passed, or because the value was unchanged and GNKLabSkipUnchangedValues was passed.
+ */
+@property (assign, nonatomic, readonly) NSUInteger skippedCount;
+
+/**
+ *  The number of transfers whose value retrieved from the source was `[NSNull null]`.
+ */
+@property (assign, nonatomic, readonly) NSUInteger nullCount;
+
+/**
+ *  The total time spent in the gene's transformer, in seconds. This is 0 if the gene has no transformer.
+ */
+@property (assign, nonatomic, readonly) NSTimeInterval transformerTime;
+
+/**
+ *  The total time spent setting values on receivers with the gene's receiving trait, in seconds.
+ */
+@property (assign, nonatomic, readonly) NSTimeInterval setterTime;
+
+@end
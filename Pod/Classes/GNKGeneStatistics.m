@@ -0,0 +1,332 @@
+//
+//  GNKGeneStatistics.m
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/28/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import "GNKGeneStatistics_Private.h"
+#import "GNKGene.h"
+#import <pthread.h>
+#import <time.h>
+
+#ifdef __APPLE__
+#import <mach/mach_time.h>
+#endif
+
+
+/**
+ *  The counters recorded for a single gene. The ivars are public so they can be updated without messaging.
+ */
+@interface _GNKGeneCounters : NSObject
+{
+    @public
+    NSUInteger _transferCount;
+    NSUInteger _skippedCount;
+    NSUInteger _nullCount;
+    uint64_t _transformerTime;
+    uint64_t _setterTime;
+}
+
+@end
+
+@implementation _GNKGeneCounters
+@end
+
+
+/**
+ *  The counters recorded by a single thread, keyed by the address of each gene. The lock is only contended while statistics are collected or reset.
+ */
+@interface _GNKGeneStatisticsThread : NSObject
+{
+    @public
+    pthread_mutex_t _lock;
+    NSMapTable *_countersForGenes;
+}
+
+@end
+
+@implementation _GNKGeneStatisticsThread
+
+- (instancetype)init
+{
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    pthread_mutex_init(&_lock, NULL);
+    _countersForGenes = [NSMapTable mapTableWithKeyOptions:(NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality)
+                                              valueOptions:NSPointerFunctionsStrongMemory];
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+@end
+
+
+#pragma mark - Recording
+
+volatile BOOL GNKGeneStatisticsEnabled = NO;
+
+static pthread_mutex_t GNKGeneStatisticsLock = PTHREAD_MUTEX_INITIALIZER;
+static NSMutableArray *GNKGeneStatisticsThreads;
+static NSMapTable *GNKGeneStatisticsExitedCounters;
+
+static pthread_key_t GNKGeneStatisticsThreadKey;
+static pthread_once_t GNKGeneStatisticsThreadKeyOnce = PTHREAD_ONCE_INIT;
+
+/**
+ *  Adds each gene's counters to the counters of an equal gene in the merged table, creating them if necessary. The caller must hold the locks for both tables.
+ */
+static void GNKGeneStatisticsMerge(NSMapTable *countersForGenes, NSMapTable *mergedCountersForGenes)
+{
+    for (GNKGene *gene in countersForGenes)
+    {
+        _GNKGeneCounters *counters = [countersForGenes objectForKey:gene];
+        _GNKGeneCounters *mergedCounters = [mergedCountersForGenes objectForKey:gene];
+        
+        if (!mergedCounters)
+        {
+            mergedCounters = [_GNKGeneCounters new];
+            [mergedCountersForGenes setObject:mergedCounters forKey:gene];
+        }
+        
+        mergedCounters->_transferCount += counters->_transferCount;
+        mergedCounters->_skippedCount += counters->_skippedCount;
+        mergedCounters->_nullCount += counters->_nullCount;
+        mergedCounters->_transformerTime += counters->_transformerTime;
+        mergedCounters->_setterTime += counters->_setterTime;
+    }
+}
+
+/**
+ *  Folds the counters of an exiting thread into the counters of exited threads, so they are still included when statistics are collected.
+ */
+static void GNKGeneStatisticsThreadExited(void *value)
+{
+    @autoreleasepool
+    {
+        _GNKGeneStatisticsThread *thread = (__bridge_transfer _GNKGeneStatisticsThread *)value;
+        
+        pthread_mutex_lock(&GNKGeneStatisticsLock);
+        pthread_mutex_lock(&thread->_lock);
+        
+        if (thread->_countersForGenes.count > 0)
+        {
+            if (!GNKGeneStatisticsExitedCounters)
+            {
+                GNKGeneStatisticsExitedCounters = [NSMapTable strongToStrongObjectsMapTable];
+            }
+            
+            GNKGeneStatisticsMerge(thread->_countersForGenes, GNKGeneStatisticsExitedCounters);
+        }
+        
+        pthread_mutex_unlock(&thread->_lock);
+        [GNKGeneStatisticsThreads removeObjectIdenticalTo:thread];
+        pthread_mutex_unlock(&GNKGeneStatisticsLock);
+    }
+}
+
+static void GNKGeneStatisticsCreateThreadKey(void)
+{
+    pthread_key_create(&GNKGeneStatisticsThreadKey, GNKGeneStatisticsThreadExited);
+}
+
+static _GNKGeneStatisticsThread *GNKGeneStatisticsCurrentThread(void)
+{
+    pthread_once(&GNKGeneStatisticsThreadKeyOnce, GNKGeneStatisticsCreateThreadKey);
+    
+    void *value = pthread_getspecific(GNKGeneStatisticsThreadKey);
+    if (value)
+    {
+        return (__bridge _GNKGeneStatisticsThread *)value;
+    }
+    
+    _GNKGeneStatisticsThread *thread = [_GNKGeneStatisticsThread new];
+    pthread_setspecific(GNKGeneStatisticsThreadKey, (__bridge_retained void *)thread);
+    
+    pthread_mutex_lock(&GNKGeneStatisticsLock);
+    
+    if (!GNKGeneStatisticsThreads)
+    {
+        GNKGeneStatisticsThreads = [NSMutableArray array];
+    }
+    
+    [GNKGeneStatisticsThreads addObject:thread];
+    pthread_mutex_unlock(&GNKGeneStatisticsLock);
+    
+    return thread;
+}
+
+uint64_t GNKGeneStatisticsTime(void)
+{
+#ifdef __APPLE__
+    return mach_absolute_time();
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+#endif
+}
+
+static NSTimeInterval GNKGeneStatisticsSeconds(uint64_t time)
+{
+#ifdef __APPLE__
+    static mach_timebase_info_data_t timebase;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        mach_timebase_info(&timebase);
+    });
+    
+    return ((double)time * timebase.numer / timebase.denom) / 1e9;
+#else
+    return (double)time / 1e9;
+#endif
+}
+
+void GNKGeneStatisticsRecord(GNKGene *gene, NSUInteger transferCount, NSUInteger skippedCount, NSUInteger nullCount, uint64_t transformerTime, uint64_t setterTime)
+{
+    _GNKGeneStatisticsThread *thread = GNKGeneStatisticsCurrentThread();
+    
+    pthread_mutex_lock(&thread->_lock);
+    
+    _GNKGeneCounters *counters = [thread->_countersForGenes objectForKey:gene];
+    if (!counters)
+    {
+        counters = [_GNKGeneCounters new];
+        [thread->_countersForGenes setObject:counters forKey:gene];
+    }
+    
+    counters->_transferCount += transferCount;
+    counters->_skippedCount += skippedCount;
+    counters->_nullCount += nullCount;
+    counters->_transformerTime += transformerTime;
+    counters->_setterTime += setterTime;
+    
+    pthread_mutex_unlock(&thread->_lock);
+}
+
+NSArray *GNKGeneStatisticsCollect(void)
+{
+    NSMapTable *countersForGenes = [NSMapTable strongToStrongObjectsMapTable];
+    
+    pthread_mutex_lock(&GNKGeneStatisticsLock);
+    
+    if (GNKGeneStatisticsExitedCounters)
+    {
+        GNKGeneStatisticsMerge(GNKGeneStatisticsExitedCounters, countersForGenes);
+    }
+    
+    for (_GNKGeneStatisticsThread *thread in GNKGeneStatisticsThreads)
+    {
+        pthread_mutex_lock(&thread->_lock);
+        GNKGeneStatisticsMerge(thread->_countersForGenes, countersForGenes);
+        pthread_mutex_unlock(&thread->_lock);
+    }
+    
+    pthread_mutex_unlock(&GNKGeneStatisticsLock);
+    
+    NSMutableArray *statistics = [NSMutableArray arrayWithCapacity:countersForGenes.count];
+    
+    for (GNKGene *gene in countersForGenes)
+    {
+        _GNKGeneCounters *counters = [countersForGenes objectForKey:gene];
+        
+        [statistics addObject:[[GNKGeneStatistics alloc] initWithGene:gene
+                                                        transferCount:counters->_transferCount
+                                                         skippedCount:counters->_skippedCount
+                                                            nullCount:counters->_nullCount
+                                                      transformerTime:GNKGeneStatisticsSeconds(counters->_transformerTime)
+                                                           setterTime:GNKGeneStatisticsSeconds(counters->_setterTime)]];
+    }
+    
+    // The most expensive genes are listed first.
+    [statistics sortUsingComparator:^NSComparisonResult(GNKGeneStatistics *statisticsA, GNKGeneStatistics *statisticsB) {
+        NSTimeInterval timeA = statisticsA.transformerTime + statisticsA.setterTime;
+        NSTimeInterval timeB = statisticsB.transformerTime + statisticsB.setterTime;
+        
+        if (timeA > timeB)
+        {
+            return NSOrderedAscending;
+        }
+        else if (timeA < timeB)
+        {
+            return NSOrderedDescending;
+        }
+        
+        return NSOrderedSame;
+    }];
+    
+    return [statistics copy];
+}
+
+void GNKGeneStatisticsReset(void)
+{
+    pthread_mutex_lock(&GNKGeneStatisticsLock);
+    
+    GNKGeneStatisticsExitedCounters = nil;
+    
+    for (_GNKGeneStatisticsThread *thread in GNKGeneStatisticsThreads)
+    {
+        pthread_mutex_lock(&thread->_lock);
+        [thread->_countersForGenes removeAllObjects];
+        pthread_mutex_unlock(&thread->_lock);
+    }
+    
+    pthread_mutex_unlock(&GNKGeneStatisticsLock);
+}
+
+
+@implementation GNKGeneStatistics
+
+#pragma mark - API
+
+- (instancetype)initWithGene:(GNKGene *)gene
+               transferCount:(NSUInteger)transferCount
+                skippedCount:(NSUInteger)skippedCount
+                   nullCount:(NSUInteger)nullCount
+             transformerTime:(NSTimeInterval)transformerTime
+                  setterTime:(NSTimeInterval)setterTime
+{
+    NSParameterAssert(gene);
+    
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    _gene = gene;
+    _transferCount = transferCount;
+    _skippedCount = skippedCount;
+    _nullCount = nullCount;
+    _transformerTime = transformerTime;
+    _setterTime = setterTime;
+    
+    return self;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init
+{
+    [self doesNotRecognizeSelector:_cmd];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+
+#pragma mark - NSObject
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p> (gene: %@, transfers: %lu, skipped: %lu, null: %lu, transformer: %.6fs, setter: %.6fs)", NSStringFromClass([self class]), self, self.gene, (unsigned long)self.transferCount, (unsigned long)self.skippedCount, (unsigned long)self.nullCount, self.transformerTime, self.setterTime];
+}
+
+@end
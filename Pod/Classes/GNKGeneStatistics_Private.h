@@ -0,0 +1,34 @@
+//
+//  GNKGeneStatistics_Private.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/28/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import "GNKGeneStatistics.h"
+
+/**
+ *  YES while GNKLab records gene statistics. Transfers check this once per gene, so it is read without synchronization.
+ */
+FOUNDATION_EXTERN volatile BOOL GNKGeneStatisticsEnabled;
+
+/**
+ *  Returns the current time in the units recorded by GNKGeneStatisticsRecord, which are converted to seconds when statistics are collected.
+ */
+FOUNDATION_EXTERN uint64_t GNKGeneStatisticsTime(void);
+
+/**
+ *  Adds to the calling thread's counters for a gene. Each thread records into its own counters, so recording never waits on another thread unless statistics are being collected at the same time.
+ */
+FOUNDATION_EXTERN void GNKGeneStatisticsRecord(GNKGene *gene, NSUInteger transferCount, NSUInteger skippedCount, NSUInteger nullCount, uint64_t transformerTime, uint64_t setterTime);
+
+/**
+ *  Combines the counters recorded by every thread, including threads which have exited, into an array of GNKGeneStatistics.
+ */
+FOUNDATION_EXTERN NSArray *GNKGeneStatisticsCollect(void);
+
+/**
+ *  Discards the counters recorded by every thread.
+ */
+FOUNDATION_EXTERN void GNKGeneStatisticsReset(void);
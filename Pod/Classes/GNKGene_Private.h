@@ -0,0 +1,18 @@
+//
+//  GNKGene_Private.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/28/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import "GNKGene.h"
+
+/**
+ *  Returns the transformer which the transformer of an inverted gene reverses.
+ *
+ *  @param transformer A gene's transformer.
+ *
+ *  @return The transformer whose reverse transformation the passed transformer performs, or nil if the passed transformer was not created by -[GNKGene invertedGene].
+ */
+FOUNDATION_EXTERN NSValueTransformer *GNKGeneReversedTransformer(NSValueTransformer *transformer);
@@ -0,0 +1,97 @@
+//
+//  GNKGenome.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/24/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class GNKGene;
+
+/**
+ *  A GNKGenome is an immutable, ordered collection of unique GNKGene objects which can be reused across any number of transfers and comparisons.
+ *
+ *  When a genome is initialized, its genes are validated and deduplicated a single time and stored in a flat layout. GNKLab methods which accept a GNKGenome can then walk the genes directly without building any intermediate collections or hashing any genes. If the same set of genes is used repeatedly, it is far cheaper to build a genome once and reuse it than to pass an array of genes to GNKLab each time.
+ *
+ *  Because a genome is immutable, it is safe to share a single instance between threads.
+ *
+ *  ```
+ *  GNKGenome *genome = [GNKGenome genomeWithGenes:@[GNKMakeGene(@"first_name", @selector(firstName)),
+ *                                                   GNKMakeGene(@"last_name", @selector(lastName))]];
+ *
+ *  [GNKLab transferTraitsFromSource:json receiver:person compiledGenome:genome options:0];
+ *  ```
+ */
+@interface GNKGenome : NSObject <NSCopying, NSFastEnumeration>
+
+/**
+ *  Convenience method which creates a genome from the given genes.
+ *
+ *  @see initWithGenes:
+ *
+ *  @param genes An array of GNKGene objects. This must contain at least one gene.
+ *
+ *  @return A new genome containing the unique genes in the array.
+ */
++ (instancetype)genomeWithGenes:(NSArray *)genes __attribute((nonnull));
+
+/**
+ *  Initializes the receiver with the given genes. This is the designated initializer.
+ *
+ *  Duplicate genes are removed, keeping the first occurrence of each gene, so the order of the remaining genes matches their order in the passed array.
+ *
+ *  @param genes An array of GNKGene objects. This must contain at least one gene.
+ *
+ *  @return An initialized instance of the receiver.
+ */
+- (instancetype)initWithGenes:(NSArray *)genes NS_DESIGNATED_INITIALIZER __attribute((nonnull));
+
+/**
+ *  The unique genes of the receiver, in order.
+ */
+@property (copy, nonatomic, readonly) NSArray *genes;
+
+/**
+ *  The number of unique genes in the receiver.
+ */
+@property (assign, nonatomic, readonly) NSUInteger count;
+
+/**
+ *  A genome of the inverted genes of the receiver, in the same order, for transfering traits in the opposite direction. Genes which cannot be inverted are left out, and this is nil if none of them can be.
+ *
+ *  The inverted genome is built the first time it is requested and is then shared, so reverse transfers cost the same as transfers using the receiver. Its genes reverse the receiver's transformers directly, without creating any objects per transfer.
+ *
+ *  @see -[GNKGene invertedGene]
+ */
+@property (strong, nonatomic, readonly) GNKGenome *invertedGenome;
+
+/**
+ *  Returns the gene at the given position in the receiver.
+ *
+ *  @param index The position of the gene. This must be less than the count of the receiver.
+ *
+ *  @return The gene at the given position.
+ */
+- (GNKGene *)geneAtIndex:(NSUInteger)index;
+
+/**
+ *  Returns the position of the given gene in the receiver.
+ *
+ *  @param gene The gene to find.
+ *
+ *  @return The position of the gene, or NSNotFound if the receiver does not contain the gene.
+ */
+- (NSUInteger)indexOfGene:(GNKGene *)gene;
+
+/**
+ *  Checks if the receiver contains the same genes in the same order as the passed genome.
+ *
+ *  @param genome The genome to compare against.
+ *
+ *  @return YES if the genomes are equivalent, NO if they are not.
+ */
+- (BOOL)isEqualToGenome:(GNKGenome *)genome;
+
+@end
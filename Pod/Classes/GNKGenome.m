@@ -0,0 +1,365 @@
+//
+//  GNKGenome.m
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/24/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import "GNKGenome_Private.h"
+#import "GNKGene_Private.h"
+#import "GNKTrait_Private.h"
+#import "GNKBatchValueTransformer.h"
+#import "GNKExpensiveValueTransformer.h"
+#import "GNKJSONMatcher_Private.h"
+#import "GNKLabProgram_Private.h"
+
+@implementation GNKGenome
+{
+    NSOrderedSet *_orderedGenes;
+    BOOL _compiledJSONMatcher;
+    BOOL _builtInvertedGenome;
+    
+    // Programs are retained by their slots, which are read without locking once they are set.
+    void *_programs[GNKLabProgramOptionsMask + 1];
+    
+    // How many times each program has been requested before it was compiled, so genomes which are used once never compile one.
+    NSUInteger _programRequestCounts[GNKLabProgramOptionsMask + 1];
+}
+
+@synthesize JSONMatcher = _JSONMatcher;
+@synthesize invertedGenome = _invertedGenome;
+
+#pragma mark - API
+
++ (instancetype)genomeWithGenes:(NSArray *)genes
+{
+    return [[self alloc] initWithGenes:genes];
+}
+
+- (instancetype)initWithGenes:(NSArray *)genes
+{
+    NSParameterAssert(genes.count > 0);
+    
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    _orderedGenes = [NSOrderedSet orderedSetWithArray:genes];
+    _genes = [_orderedGenes array];
+    _count = _genes.count;
+    
+    GNKGenomeEntry *entries = calloc(_count, sizeof(GNKGenomeEntry));
+    
+    NSUInteger index = 0;
+    for (GNKGene *gene in _genes)
+    {
+        NSParameterAssert([gene isKindOfClass:[GNKGene class]]);
+        
+        entries[index].gene = gene;
+        entries[index].sourceTrait = gene.sourceTrait;
+        entries[index].receivingTrait = gene.receivingTrait;
+        entries[index].transformer = gene.transformer;
+        entries[index].copiesScalarValues = !gene.transformer && GNKTraitIsKeyTrait(gene.sourceTrait) && GNKTraitIsKeyTrait(gene.receivingTrait);
+        entries[index].transformsInBatches = [gene.transformer conformsToProtocol:@protocol(GNKBatchValueTransformer)];
+        _hasBatchTransformers = _hasBatchTransformers || entries[index].transformsInBatches;
+        
+        // Inverted genes reverse their transformer directly instead of going through the wrapper.
+        NSValueTransformer *reversedTransformer = GNKGeneReversedTransformer(gene.transformer);
+        if (reversedTransformer)
+        {
+            entries[index].transformer = reversedTransformer;
+            entries[index].reversesTransformer = YES;
+        }
+        
+        entries[index].evaluatesConcurrently = [entries[index].transformer conformsToProtocol:@protocol(GNKExpensiveValueTransformer)];
+        _concurrentEntryCount += entries[index].evaluatesConcurrently ? 1 : 0;
+        entries[index].prefixNode = NSNotFound;
+        
+        id component = GNKTraitCollectionComponent(gene.receivingTrait);
+        entries[index].receivingKey = [component isKindOfClass:[NSString class]] ? component : nil;
+        entries[index].receivingIndex = [component isKindOfClass:[NSNumber class]] ? [component unsignedIntegerValue] : NSNotFound;
+        index++;
+    }
+    
+    _entries = entries;
+    
+    if (_concurrentEntryCount > 0)
+    {
+        NSUInteger *concurrentEntryIndexes = malloc(_concurrentEntryCount * sizeof(NSUInteger));
+        NSUInteger concurrentIndex = 0;
+        
+        for (NSUInteger i = 0; i < _count; i++)
+        {
+            if (entries[i].evaluatesConcurrently)
+            {
+                concurrentEntryIndexes[concurrentIndex++] = i;
+            }
+        }
+        
+        _concurrentEntryIndexes = concurrentEntryIndexes;
+    }
+    
+    [self buildPrefixNodes];
+    [self resolveReceiverShape];
+    
+    return self;
+}
+
+/**
+ *  Determines whether every receiving trait sets a distinct key or a distinct index, in which case a dictionary or array receiver can be built from all of the values at once.
+ */
+- (void)resolveReceiverShape
+{
+    NSMutableSet *receivingKeys = [NSMutableSet setWithCapacity:_count];
+    NSMutableIndexSet *receivingIndexes = [NSMutableIndexSet indexSet];
+    
+    for (NSUInteger i = 0; i < _count; i++)
+    {
+        if (_entries[i].receivingKey)
+        {
+            [receivingKeys addObject:_entries[i].receivingKey];
+        }
+        else if (_entries[i].receivingIndex != NSNotFound)
+        {
+            [receivingIndexes addIndex:_entries[i].receivingIndex];
+        }
+    }
+    
+    if (receivingKeys.count == _count)
+    {
+        _receiverShape = GNKGenomeReceiverShapeKeys;
+    }
+    else if (receivingIndexes.count == _count)
+    {
+        _receiverShape = GNKGenomeReceiverShapeIndexes;
+    }
+}
+
+/**
+ *  Builds a trie from the traits of each sequence source trait, so that traits shared by the start of several sequences are only evaluated once per transfer. The trie is discarded if no traits are shared.
+ */
+- (void)buildPrefixNodes
+{
+    GNKGenomeEntry *entries = (GNKGenomeEntry *)_entries;
+    
+    NSMutableData *nodes = [NSMutableData data];
+    NSMutableArray *childrenForNodes = [NSMutableArray array];
+    NSMutableDictionary *rootChildren = [NSMutableDictionary dictionary];
+    NSUInteger sequenceTraitCount = 0;
+    
+    for (NSUInteger i = 0; i < _count; i++)
+    {
+        NSArray *sequence = GNKTraitSequence(entries[i].sourceTrait);
+        if (!sequence)
+        {
+            continue;
+        }
+        
+        NSUInteger parent = NSNotFound;
+        
+        for (id trait in sequence)
+        {
+            NSMutableDictionary *children = (parent == NSNotFound) ? rootChildren : childrenForNodes[parent];
+            NSNumber *node = children[trait];
+            
+            if (!node)
+            {
+                GNKGenomePrefixNode prefixNode = { trait, parent };
+                [nodes appendBytes:&prefixNode length:sizeof(prefixNode)];
+                
+                node = @(childrenForNodes.count);
+                children[trait] = node;
+                [childrenForNodes addObject:[NSMutableDictionary dictionary]];
+            }
+            
+            parent = node.unsignedIntegerValue;
+        }
+        
+        entries[i].prefixNode = parent;
+        sequenceTraitCount += sequence.count;
+    }
+    
+    _prefixNodeCount = childrenForNodes.count;
+    
+    if (_prefixNodeCount == sequenceTraitCount)
+    {
+        for (NSUInteger i = 0; i < _count; i++)
+        {
+            entries[i].prefixNode = NSNotFound;
+        }
+        
+        _prefixNodeCount = 0;
+        return;
+    }
+    
+    GNKGenomePrefixNode *prefixNodes = malloc(nodes.length);
+    memcpy(prefixNodes, nodes.bytes, nodes.length);
+    _prefixNodes = prefixNodes;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init
+{
+    [self doesNotRecognizeSelector:_cmd];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (void)dealloc
+{
+    free((void *)_entries);
+    free((void *)_prefixNodes);
+    free((void *)_concurrentEntryIndexes);
+    
+    for (NSUInteger i = 0; i <= GNKLabProgramOptionsMask; i++)
+    {
+        if (_programs[i])
+        {
+            (void)(__bridge_transfer GNKLabProgram *)_programs[i];
+        }
+    }
+}
+
+- (GNKJSONMatcher *)JSONMatcher
+{
+    @synchronized(self)
+    {
+        if (!_compiledJSONMatcher)
+        {
+            _JSONMatcher = [GNKJSONMatcher matcherWithGenome:self];
+            _compiledJSONMatcher = YES;
+        }
+        
+        return _JSONMatcher;
+    }
+}
+
+- (GNKGenome *)invertedGenome
+{
+    @synchronized(self)
+    {
+        if (!_builtInvertedGenome)
+        {
+            NSMutableArray *invertedGenes = [NSMutableArray arrayWithCapacity:_count];
+            
+            for (GNKGene *gene in _genes)
+            {
+                GNKGene *invertedGene = [gene invertedGene];
+                if (invertedGene)
+                {
+                    [invertedGenes addObject:invertedGene];
+                }
+            }
+            
+            _invertedGenome = (invertedGenes.count > 0) ? [[GNKGenome alloc] initWithGenes:invertedGenes] : nil;
+            _builtInvertedGenome = YES;
+        }
+        
+        return _invertedGenome;
+    }
+}
+
+- (GNKLabProgram *)programForOptions:(GNKLabOptions)options
+{
+    NSUInteger slot = (NSUInteger)(options & GNKLabProgramOptionsMask);
+    
+    void *program = __atomic_load_n(&_programs[slot], __ATOMIC_ACQUIRE);
+    if (program)
+    {
+        return (__bridge GNKLabProgram *)program;
+    }
+    
+    // Compiling costs more than transferring once, so a program is only compiled once the genome is reused for the options.
+    if (__atomic_fetch_add(&_programRequestCounts[slot], 1, __ATOMIC_RELAXED) == 0)
+    {
+        return nil;
+    }
+    
+    @synchronized(self)
+    {
+        program = _programs[slot];
+        
+        if (!program)
+        {
+            program = (__bridge_retained void *)[GNKLabProgram programWithGenome:self options:options];
+            __atomic_store_n(&_programs[slot], program, __ATOMIC_RELEASE);
+        }
+        
+        return (__bridge GNKLabProgram *)program;
+    }
+}
+
+- (GNKGene *)geneAtIndex:(NSUInteger)index
+{
+    NSParameterAssert(index < self.count);
+    
+    return self.entries[index].gene;
+}
+
+- (NSUInteger)indexOfGene:(GNKGene *)gene
+{
+    if (!gene)
+    {
+        return NSNotFound;
+    }
+    
+    return [_orderedGenes indexOfObject:gene];
+}
+
+- (BOOL)isEqualToGenome:(GNKGenome *)genome
+{
+    if (!genome)
+    {
+        return NO;
+    }
+    
+    return [self.genes isEqualToArray:genome.genes];
+}
+
+
+#pragma mark - NSObject
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p> (\n\t%@\n)", NSStringFromClass([self class]), self, [self.genes componentsJoinedByString:@",\n\t"]];
+}
+
+- (BOOL)isEqual:(id)object
+{
+    if (self == object)
+    {
+        return YES;
+    }
+    else if (![object isKindOfClass:[GNKGenome class]])
+    {
+        return NO;
+    }
+    
+    return [self isEqualToGenome:object];
+}
+
+- (NSUInteger)hash
+{
+    return self.genes.hash;
+}
+
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    return self;
+}
+
+
+#pragma mark - NSFastEnumeration
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state objects:(id __unsafe_unretained [])buffer count:(NSUInteger)len
+{
+    return [self.genes countByEnumeratingWithState:state objects:buffer count:len];
+}
+
+@end
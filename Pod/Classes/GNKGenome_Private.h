@@ -0,0 +1,144 @@
+//
+//  GNKGenome_Private.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/24/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import "GNKGenome.h"
+#import "GNKLab.h"
+
+@class GNKJSONMatcher, GNKLabProgram;
+@protocol GNKSourceTrait, GNKReceivingTrait;
+
+/**
+ *  A node in the trie of source trait prefixes shared by the genes of a genome. Each node evaluates a single trait of a sequence against the value of its parent node, or against the source object if it has no parent.
+ */
+typedef struct
+{
+    __unsafe_unretained id<GNKSourceTrait> trait;
+    
+    /**
+     *  The position of the parent node, which always precedes its children, or NSNotFound if the trait is evaluated against the source object.
+     */
+    NSUInteger parent;
+} GNKGenomePrefixNode;
+
+/**
+ *  The flattened representation of a single gene in a genome. The pointers are unretained, since the genome retains the genes and the genes retain their traits and transformers.
+ */
+typedef struct
+{
+    __unsafe_unretained GNKGene *gene;
+    __unsafe_unretained id<GNKSourceTrait> sourceTrait;
+    __unsafe_unretained id<GNKReceivingTrait> receivingTrait;
+    __unsafe_unretained NSValueTransformer *transformer;
+    
+    /**
+     *  YES if the gene's transformer was created by -[GNKGene invertedGene], in which case the transformer is the one it wraps and values are passed to its -reverseTransformedValue: directly.
+     */
+    BOOL reversesTransformer;
+    
+    /**
+     *  YES if the gene has no transformer and both traits are key traits, in which case scalar values may be copied without boxing them.
+     */
+    BOOL copiesScalarValues;
+    
+    /**
+     *  YES if the gene's transformer conforms to GNKBatchValueTransformer, in which case values for many objects may be transformed together.
+     */
+    BOOL transformsInBatches;
+    
+    /**
+     *  YES if the gene's transformer conforms to GNKExpensiveValueTransformer, in which case its value may be evaluated on another thread.
+     */
+    BOOL evaluatesConcurrently;
+    
+    /**
+     *  The position of the prefix node whose value is the gene's source value, or NSNotFound if the source trait is evaluated directly.
+     */
+    NSUInteger prefixNode;
+    
+    /**
+     *  The key the receiving trait sets on a dictionary if it is a key trait with a single segment, or nil.
+     */
+    __unsafe_unretained NSString *receivingKey;
+    
+    /**
+     *  The position the receiving trait sets in an array if it is an index trait with a non-negative index, or NSNotFound.
+     */
+    NSUInteger receivingIndex;
+} GNKGenomeEntry;
+
+/**
+ *  Describes which collections the receiving traits of a genome can set all of their values on at once.
+ */
+typedef NS_ENUM(NSUInteger, GNKGenomeReceiverShape)
+{
+    /**
+     *  The receiving traits must set their values one at a time.
+     */
+    GNKGenomeReceiverShapeAny = 0,
+    /**
+     *  Every entry has a receiving key, and no two entries share one, so a dictionary receiver can be set in bulk.
+     */
+    GNKGenomeReceiverShapeKeys,
+    /**
+     *  Every entry has a receiving index, and no two entries share one, so an array receiver can be set in bulk.
+     */
+    GNKGenomeReceiverShapeIndexes
+};
+
+@interface GNKGenome ()
+
+/**
+ *  A contiguous array of entries, one for each gene in the receiver and in the same order. The array contains exactly `count` entries and is valid for the lifetime of the receiver.
+ */
+@property (assign, nonatomic, readonly) const GNKGenomeEntry *entries;
+
+/**
+ *  The prefix nodes of the sequence source traits, in an order where each parent precedes its children. This is NULL if no two sequences share a prefix, in which case no entry uses a prefix node.
+ */
+@property (assign, nonatomic, readonly) const GNKGenomePrefixNode *prefixNodes;
+
+/**
+ *  The number of prefix nodes.
+ */
+@property (assign, nonatomic, readonly) NSUInteger prefixNodeCount;
+
+/**
+ *  Which collections the receiving traits can set all of their values on at once.
+ */
+@property (assign, nonatomic, readonly) GNKGenomeReceiverShape receiverShape;
+
+/**
+ *  YES if any entry transforms its values in batches.
+ */
+@property (assign, nonatomic, readonly) BOOL hasBatchTransformers;
+
+/**
+ *  The positions of the entries which evaluate concurrently, in ascending order, or NULL if there are none.
+ */
+@property (assign, nonatomic, readonly) const NSUInteger *concurrentEntryIndexes;
+
+/**
+ *  The number of entries which evaluate concurrently.
+ */
+@property (assign, nonatomic, readonly) NSUInteger concurrentEntryCount;
+
+/**
+ *  A matcher for the source traits of the receiver, compiled the first time it is requested. This is nil if any source trait cannot be matched in JSON.
+ */
+@property (strong, nonatomic, readonly) GNKJSONMatcher *JSONMatcher;
+
+/**
+ *  Returns the receiver compiled for the options, compiling it the second time the options are used. Genomes built for a single transfer, like those made from arrays of genes, are never compiled, since compiling costs more than transferring each entry once. Compiled programs are kept for the lifetime of the receiver.
+ *
+ *  @param options The options to compile the receiver for. Only the options in GNKLabProgramOptionsMask are used, so options which differ only in other options share a program.
+ *
+ *  @return The compiled program, or nil the first time the options are used.
+ */
+- (GNKLabProgram *)programForOptions:(GNKLabOptions)options;
+
+@end
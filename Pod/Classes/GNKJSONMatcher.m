@@ -0,0 +1,1037 @@
+//
+//  GNKJSONMatcher.m
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/27/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import "GNKJSONMatcher_Private.h"
+#import "GNKGenome_Private.h"
+#import "GNKLab.h"
+#import "GNKTrait_Private.h"
+#import <errno.h>
+#import <locale.h>
+#import <stdlib.h>
+#ifdef __APPLE__
+#import <xlocale.h>
+#endif
+
+typedef struct
+{
+    const uint8_t *bytes;
+    NSUInteger length;
+    NSUInteger position;
+} GNKJSONScanner;
+
+@interface _GNKJSONPathNode : NSObject
+
+- (_GNKJSONPathNode *)addChildForComponent:(id)component;
+
+- (void)addGeneIndex:(NSUInteger)geneIndex;
+
+- (void)finishBuilding;
+
+@end
+
+
+#pragma mark - Scanning
+
+static BOOL GNKJSONFail(GNKJSONScanner *scanner, NSError **error)
+{
+    if (error)
+    {
+        NSString *description = [NSString stringWithFormat:@"The JSON data is invalid around byte %lu.", (unsigned long)scanner->position];
+        *error = [NSError errorWithDomain:GNKLabErrorDomain code:GNKLabErrorInvalidJSON userInfo:@{NSLocalizedDescriptionKey: description}];
+    }
+    
+    return NO;
+}
+
+static inline void GNKJSONSkipWhitespace(GNKJSONScanner *scanner)
+{
+    while (scanner->position < scanner->length)
+    {
+        uint8_t byte = scanner->bytes[scanner->position];
+        if (byte != ' ' && byte != '\n' && byte != '\r' && byte != '\t')
+        {
+            return;
+        }
+        
+        scanner->position++;
+    }
+}
+
+static inline BOOL GNKJSONScanByte(GNKJSONScanner *scanner, uint8_t byte)
+{
+    GNKJSONSkipWhitespace(scanner);
+    
+    if (scanner->position < scanner->length && scanner->bytes[scanner->position] == byte)
+    {
+        scanner->position++;
+        return YES;
+    }
+    
+    return NO;
+}
+
+static inline int GNKJSONPeek(GNKJSONScanner *scanner)
+{
+    GNKJSONSkipWhitespace(scanner);
+    
+    return (scanner->position < scanner->length) ? scanner->bytes[scanner->position] : -1;
+}
+
+/**
+ *  Scans past a string, which must begin at the current position, and reports the range of its raw contents between the quotes.
+ */
+static BOOL GNKJSONScanStringRange(GNKJSONScanner *scanner, NSRange *range, BOOL *hasEscapes)
+{
+    if (!GNKJSONScanByte(scanner, '"'))
+    {
+        return NO;
+    }
+    
+    NSUInteger start = scanner->position;
+    *hasEscapes = NO;
+    
+    while (scanner->position < scanner->length)
+    {
+        uint8_t byte = scanner->bytes[scanner->position];
+        
+        if (byte == '"')
+        {
+            *range = NSMakeRange(start, scanner->position - start);
+            scanner->position++;
+            return YES;
+        }
+        else if (byte == '\\')
+        {
+            *hasEscapes = YES;
+            scanner->position += 2;
+        }
+        else if (byte < 0x20)
+        {
+            return NO;
+        }
+        else
+        {
+            scanner->position++;
+        }
+    }
+    
+    return NO;
+}
+
+static inline int GNKJSONHexValue(uint8_t byte)
+{
+    if (byte >= '0' && byte <= '9')
+    {
+        return byte - '0';
+    }
+    else if (byte >= 'a' && byte <= 'f')
+    {
+        return byte - 'a' + 10;
+    }
+    else if (byte >= 'A' && byte <= 'F')
+    {
+        return byte - 'A' + 10;
+    }
+    
+    return -1;
+}
+
+static BOOL GNKJSONScanHexQuad(const uint8_t *bytes, NSUInteger length, NSUInteger position, uint32_t *value)
+{
+    if (position + 4 > length)
+    {
+        return NO;
+    }
+    
+    *value = 0;
+    for (NSUInteger i = position; i < position + 4; i++)
+    {
+        int hexValue = GNKJSONHexValue(bytes[i]);
+        if (hexValue < 0)
+        {
+            return NO;
+        }
+        
+        *value = (*value << 4) | (uint32_t)hexValue;
+    }
+    
+    return YES;
+}
+
+static void GNKJSONAppendCodePoint(NSMutableData *data, uint32_t codePoint)
+{
+    uint8_t encoded[4];
+    NSUInteger length;
+    
+    if (codePoint < 0x80)
+    {
+        encoded[0] = (uint8_t)codePoint;
+        length = 1;
+    }
+    else if (codePoint < 0x800)
+    {
+        encoded[0] = (uint8_t)(0xC0 | (codePoint >> 6));
+        encoded[1] = (uint8_t)(0x80 | (codePoint & 0x3F));
+        length = 2;
+    }
+    else if (codePoint < 0x10000)
+    {
+        encoded[0] = (uint8_t)(0xE0 | (codePoint >> 12));
+        encoded[1] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+        encoded[2] = (uint8_t)(0x80 | (codePoint & 0x3F));
+        length = 3;
+    }
+    else
+    {
+        encoded[0] = (uint8_t)(0xF0 | (codePoint >> 18));
+        encoded[1] = (uint8_t)(0x80 | ((codePoint >> 12) & 0x3F));
+        encoded[2] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+        encoded[3] = (uint8_t)(0x80 | (codePoint & 0x3F));
+        length = 4;
+    }
+    
+    [data appendBytes:encoded length:length];
+}
+
+/**
+ *  Decodes the raw contents of a string into UTF-8 bytes, resolving any escape sequences.
+ */
+static NSData *GNKJSONUnescapedData(const uint8_t *bytes, NSRange range, BOOL hasEscapes)
+{
+    if (!hasEscapes)
+    {
+        return [NSData dataWithBytesNoCopy:(void *)(bytes + range.location) length:range.length freeWhenDone:NO];
+    }
+    
+    NSMutableData *data = [NSMutableData dataWithCapacity:range.length];
+    NSUInteger end = NSMaxRange(range);
+    NSUInteger position = range.location;
+    
+    while (position < end)
+    {
+        NSUInteger runStart = position;
+        while (position < end && bytes[position] != '\\')
+        {
+            position++;
+        }
+        
+        [data appendBytes:(bytes + runStart) length:(position - runStart)];
+        
+        if (position >= end)
+        {
+            break;
+        }
+        
+        if (position + 1 >= end)
+        {
+            return nil;
+        }
+        
+        uint8_t escaped = bytes[position + 1];
+        position += 2;
+        
+        uint8_t unescaped;
+        switch (escaped)
+        {
+            case '"': unescaped = '"'; break;
+            case '\\': unescaped = '\\'; break;
+            case '/': unescaped = '/'; break;
+            case 'b': unescaped = '\b'; break;
+            case 'f': unescaped = '\f'; break;
+            case 'n': unescaped = '\n'; break;
+            case 'r': unescaped = '\r'; break;
+            case 't': unescaped = '\t'; break;
+            case 'u':
+            {
+                uint32_t codePoint;
+                if (!GNKJSONScanHexQuad(bytes, end, position, &codePoint))
+                {
+                    return nil;
+                }
+                
+                position += 4;
+                
+                // Characters outside the basic multilingual plane are escaped as a pair of surrogates.
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+                {
+                    uint32_t lowSurrogate;
+                    if (position + 2 > end || bytes[position] != '\\' || bytes[position + 1] != 'u' ||
+                        !GNKJSONScanHexQuad(bytes, end, position + 2, &lowSurrogate) ||
+                        lowSurrogate < 0xDC00 || lowSurrogate > 0xDFFF)
+                    {
+                        return nil;
+                    }
+                    
+                    position += 6;
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+                }
+                else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF)
+                {
+                    return nil;
+                }
+                
+                GNKJSONAppendCodePoint(data, codePoint);
+                continue;
+            }
+            default:
+                return nil;
+        }
+        
+        [data appendBytes:&unescaped length:1];
+    }
+    
+    return data;
+}
+
+static NSString *GNKJSONScanString(GNKJSONScanner *scanner)
+{
+    NSRange range;
+    BOOL hasEscapes;
+    if (!GNKJSONScanStringRange(scanner, &range, &hasEscapes))
+    {
+        return nil;
+    }
+    
+    NSData *data = GNKJSONUnescapedData(scanner->bytes, range, hasEscapes);
+    if (!data)
+    {
+        return nil;
+    }
+    
+    return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+}
+
+static inline BOOL GNKJSONScanDigits(GNKJSONScanner *scanner)
+{
+    NSUInteger start = scanner->position;
+    
+    while (scanner->position < scanner->length && scanner->bytes[scanner->position] >= '0' && scanner->bytes[scanner->position] <= '9')
+    {
+        scanner->position++;
+    }
+    
+    return (scanner->position > start);
+}
+
+static inline BOOL GNKJSONScanOptionalByte(GNKJSONScanner *scanner, uint8_t byte)
+{
+    if (scanner->position < scanner->length && scanner->bytes[scanner->position] == byte)
+    {
+        scanner->position++;
+        return YES;
+    }
+    
+    return NO;
+}
+
+/**
+ *  Scans a number following the grammar of RFC 8259, `-? (0 | [1-9][0-9]*) (. [0-9]+)? ([eE] [+-]? [0-9]+)?`, so only numbers NSJSONSerialization accepts are scanned.
+ */
+static BOOL GNKJSONScanNumberRange(GNKJSONScanner *scanner, NSRange *range, BOOL *isInteger)
+{
+    GNKJSONSkipWhitespace(scanner);
+    
+    NSUInteger start = scanner->position;
+    *isInteger = YES;
+    
+    GNKJSONScanOptionalByte(scanner, '-');
+    
+    // A leading zero is a complete integer part, so any digits after it are left to fail as the next token.
+    if (!GNKJSONScanOptionalByte(scanner, '0') && !GNKJSONScanDigits(scanner))
+    {
+        return NO;
+    }
+    
+    if (GNKJSONScanOptionalByte(scanner, '.'))
+    {
+        *isInteger = NO;
+        
+        if (!GNKJSONScanDigits(scanner))
+        {
+            return NO;
+        }
+    }
+    
+    if (GNKJSONScanOptionalByte(scanner, 'e') || GNKJSONScanOptionalByte(scanner, 'E'))
+    {
+        *isInteger = NO;
+        
+        if (!GNKJSONScanOptionalByte(scanner, '+'))
+        {
+            GNKJSONScanOptionalByte(scanner, '-');
+        }
+        
+        if (!GNKJSONScanDigits(scanner))
+        {
+            return NO;
+        }
+    }
+    
+    *range = NSMakeRange(start, scanner->position - start);
+    return YES;
+}
+
+/**
+ *  Returns the C locale, so numbers are parsed with a period as the decimal point whatever the locale of the process.
+ */
+static locale_t GNKJSONNumericLocale(void)
+{
+    static locale_t locale;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        locale = newlocale(LC_ALL_MASK, "C", NULL);
+    });
+    
+    return locale;
+}
+
+static NSNumber *GNKJSONScanNumber(GNKJSONScanner *scanner)
+{
+    NSRange range;
+    BOOL isInteger;
+    char buffer[64];
+    if (!GNKJSONScanNumberRange(scanner, &range, &isInteger))
+    {
+        return nil;
+    }
+    
+    // Long literals, such as high precision decimals, are valid but do not fit the buffer, so they are parsed exactly as NSJSONSerialization parses them.
+    if (range.length >= sizeof(buffer))
+    {
+        NSData *data = [NSData dataWithBytesNoCopy:(void *)(scanner->bytes + range.location) length:range.length freeWhenDone:NO];
+        NSNumber *number = [NSJSONSerialization JSONObjectWithData:data options:NSJSONReadingAllowFragments error:NULL];
+        
+        if ([number isKindOfClass:[NSNumber class]])
+        {
+            return number;
+        }
+        
+        NSString *string = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+        return [NSDecimalNumber decimalNumberWithString:string locale:@{NSLocaleDecimalSeparator: @"."}];
+    }
+    
+    NSUInteger length = range.length;
+    memcpy(buffer, scanner->bytes + range.location, length);
+    buffer[length] = '\0';
+    
+    char *end;
+    if (isInteger)
+    {
+        errno = 0;
+        long long integerValue = strtoll(buffer, &end, 10);
+        if (errno == 0 && end == buffer + length)
+        {
+            return @(integerValue);
+        }
+    }
+    
+    double doubleValue = strtod_l(buffer, &end, GNKJSONNumericLocale());
+    return (end == buffer + length) ? @(doubleValue) : nil;
+}
+
+static BOOL GNKJSONScanLiteral(GNKJSONScanner *scanner, const char *literal, size_t length)
+{
+    GNKJSONSkipWhitespace(scanner);
+    
+    if (scanner->position + length > scanner->length || memcmp(scanner->bytes + scanner->position, literal, length) != 0)
+    {
+        return NO;
+    }
+    
+    scanner->position += length;
+    return YES;
+}
+
+typedef NS_ENUM(NSUInteger, _GNKJSONSkipState)
+{
+    _GNKJSONSkipExpectingValue,
+    _GNKJSONSkipExpectingValueOrClose,
+    _GNKJSONSkipExpectingKey,
+    _GNKJSONSkipExpectingKeyOrClose,
+    _GNKJSONSkipExpectingColon,
+    _GNKJSONSkipExpectingSeparatorOrClose
+};
+
+/**
+ *  Scans past a string, number or literal at the current position without materializing it.
+ */
+static BOOL GNKJSONSkipScalar(GNKJSONScanner *scanner, int byte)
+{
+    NSRange range;
+    BOOL flag;
+    
+    switch (byte)
+    {
+        case '"': return GNKJSONScanStringRange(scanner, &range, &flag);
+        case 't': return GNKJSONScanLiteral(scanner, "true", 4);
+        case 'f': return GNKJSONScanLiteral(scanner, "false", 5);
+        case 'n': return GNKJSONScanLiteral(scanner, "null", 4);
+        default: return GNKJSONScanNumberRange(scanner, &range, &flag);
+    }
+}
+
+/**
+ *  Scans past the value at the current position without materializing it. Open containers are tracked with an explicit stack rather than recursion, so deeply nested values cannot exhaust the call stack. Skipped values are checked against the full JSON grammar, so separators, keys and colons must appear exactly where JSON allows them.
+ */
+static BOOL GNKJSONSkipValue(GNKJSONScanner *scanner)
+{
+    uint8_t inlineOpeners[64];
+    uint8_t *openers = inlineOpeners;
+    NSUInteger capacity = sizeof(inlineOpeners);
+    NSUInteger depth = 0;
+    _GNKJSONSkipState state = _GNKJSONSkipExpectingValue;
+    BOOL skipped = YES;
+    
+    do
+    {
+        int byte = GNKJSONPeek(scanner);
+        BOOL closed = NO;
+        
+        switch (state)
+        {
+            case _GNKJSONSkipExpectingValue:
+            case _GNKJSONSkipExpectingValueOrClose:
+                if (byte == ']' && state == _GNKJSONSkipExpectingValueOrClose)
+                {
+                    closed = YES;
+                }
+                else if (byte == '{' || byte == '[')
+                {
+                    if (depth == capacity)
+                    {
+                        capacity *= 2;
+                        
+                        if (openers == inlineOpeners)
+                        {
+                            openers = (uint8_t *)malloc(capacity);
+                            memcpy(openers, inlineOpeners, depth);
+                        }
+                        else
+                        {
+                            openers = (uint8_t *)realloc(openers, capacity);
+                        }
+                    }
+                    
+                    openers[depth++] = (uint8_t)byte;
+                    scanner->position++;
+                    state = (byte == '{') ? _GNKJSONSkipExpectingKeyOrClose : _GNKJSONSkipExpectingValueOrClose;
+                    continue;
+                }
+                else
+                {
+                    skipped = GNKJSONSkipScalar(scanner, byte);
+                    state = _GNKJSONSkipExpectingSeparatorOrClose;
+                }
+                break;
+                
+            case _GNKJSONSkipExpectingKey:
+            case _GNKJSONSkipExpectingKeyOrClose:
+                if (byte == '}' && state == _GNKJSONSkipExpectingKeyOrClose)
+                {
+                    closed = YES;
+                }
+                else
+                {
+                    skipped = (byte == '"') && GNKJSONSkipScalar(scanner, byte);
+                    state = _GNKJSONSkipExpectingColon;
+                }
+                break;
+                
+            case _GNKJSONSkipExpectingColon:
+                skipped = GNKJSONScanByte(scanner, ':');
+                state = _GNKJSONSkipExpectingValue;
+                break;
+                
+            case _GNKJSONSkipExpectingSeparatorOrClose:
+                if (byte == ',')
+                {
+                    scanner->position++;
+                    state = (openers[depth - 1] == '{') ? _GNKJSONSkipExpectingKey : _GNKJSONSkipExpectingValue;
+                }
+                else
+                {
+                    skipped = (byte == ((openers[depth - 1] == '{') ? '}' : ']'));
+                    closed = YES;
+                }
+                break;
+        }
+        
+        if (skipped && closed)
+        {
+            depth--;
+            scanner->position++;
+            state = _GNKJSONSkipExpectingSeparatorOrClose;
+        }
+    }
+    while (skipped && (depth > 0 || state != _GNKJSONSkipExpectingSeparatorOrClose));
+    
+    if (openers != inlineOpeners)
+    {
+        free(openers);
+    }
+    
+    return skipped;
+}
+
+/**
+ *  Parses the value at the current position. Containers are located by skipping them, then parsed from their range of bytes.
+ */
+static id GNKJSONScanValue(GNKJSONScanner *scanner, NSError **error)
+{
+    int byte = GNKJSONPeek(scanner);
+    
+    if (byte == '{' || byte == '[')
+    {
+        NSUInteger start = scanner->position;
+        if (!GNKJSONSkipValue(scanner))
+        {
+            GNKJSONFail(scanner, error);
+            return nil;
+        }
+        
+        NSData *data = [NSData dataWithBytesNoCopy:(void *)(scanner->bytes + start) length:(scanner->position - start) freeWhenDone:NO];
+        return [NSJSONSerialization JSONObjectWithData:data options:0 error:error];
+    }
+    
+    id value;
+    if (byte == '"')
+    {
+        value = GNKJSONScanString(scanner);
+    }
+    else if (byte == 't')
+    {
+        value = GNKJSONScanLiteral(scanner, "true", 4) ? @YES : nil;
+    }
+    else if (byte == 'f')
+    {
+        value = GNKJSONScanLiteral(scanner, "false", 5) ? @NO : nil;
+    }
+    else if (byte == 'n')
+    {
+        value = GNKJSONScanLiteral(scanner, "null", 4) ? [NSNull null] : nil;
+    }
+    else
+    {
+        value = GNKJSONScanNumber(scanner);
+    }
+    
+    if (!value)
+    {
+        GNKJSONFail(scanner, error);
+    }
+    
+    return value;
+}
+
+
+#pragma mark - Path nodes
+
+/**
+ *  A node in the trie of gene paths. Each node is reached by following a single key or index from its parent, and records the genes whose paths end at it.
+ */
+@implementation _GNKJSONPathNode
+{
+    @package
+    NSMutableArray *_keys;
+    NSMutableArray *_keyChildren;
+    NSMutableDictionary *_indexChildren;
+    NSUInteger _maximumIndex;
+    NSMutableIndexSet *_geneIndexes;
+    
+    // UTF-8 representations of the keys, so they can be compared with the raw bytes of JSON keys.
+    NSArray *_keysData;
+    __unsafe_unretained NSData **_keysDataObjects;
+    NSUInteger _keyCount;
+}
+
+- (instancetype)init
+{
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    _keys = [NSMutableArray array];
+    _keyChildren = [NSMutableArray array];
+    _indexChildren = [NSMutableDictionary dictionary];
+    _geneIndexes = [NSMutableIndexSet indexSet];
+    
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_keysDataObjects);
+}
+
+- (_GNKJSONPathNode *)addChildForComponent:(id)component
+{
+    _GNKJSONPathNode *child;
+    
+    if ([component isKindOfClass:[NSNumber class]])
+    {
+        child = _indexChildren[component];
+        if (!child)
+        {
+            child = [_GNKJSONPathNode new];
+            _indexChildren[component] = child;
+            _maximumIndex = MAX(_maximumIndex, [component unsignedIntegerValue]);
+        }
+    }
+    else
+    {
+        NSUInteger index = [_keys indexOfObject:component];
+        if (index != NSNotFound)
+        {
+            child = _keyChildren[index];
+        }
+        else
+        {
+            child = [_GNKJSONPathNode new];
+            [_keys addObject:component];
+            [_keyChildren addObject:child];
+        }
+    }
+    
+    return child;
+}
+
+- (void)addGeneIndex:(NSUInteger)geneIndex
+{
+    [_geneIndexes addIndex:geneIndex];
+}
+
+- (void)finishBuilding
+{
+    NSMutableArray *keysData = [NSMutableArray arrayWithCapacity:_keys.count];
+    for (NSString *key in _keys)
+    {
+        [keysData addObject:[key dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+    
+    _keysData = [keysData copy];
+    _keyCount = _keysData.count;
+    _keysDataObjects = (__unsafe_unretained NSData **)calloc(_keyCount, sizeof(NSData *));
+    [_keysData getObjects:_keysDataObjects range:NSMakeRange(0, _keyCount)];
+    
+    for (_GNKJSONPathNode *child in _keyChildren)
+    {
+        [child finishBuilding];
+    }
+    
+    for (_GNKJSONPathNode *child in [_indexChildren objectEnumerator])
+    {
+        [child finishBuilding];
+    }
+}
+
+- (_GNKJSONPathNode *)childForKeyBytes:(const uint8_t *)bytes length:(NSUInteger)length
+{
+    for (NSUInteger i = 0; i < _keyCount; i++)
+    {
+        NSData *keyData = _keysDataObjects[i];
+        if (keyData.length == length && memcmp(keyData.bytes, bytes, length) == 0)
+        {
+            return _keyChildren[i];
+        }
+    }
+    
+    return nil;
+}
+
+/**
+ *  Assigns an already materialized value to the genes of the receiver, and the values nested within it to the genes of its descendants. Keys are looked up in arrays with -valueForKey:, which maps the key over the elements exactly as key-value coding does when a key path passes through an array.
+ */
+- (void)assignValue:(id)value values:(__strong id *)values
+{
+    [_geneIndexes enumerateIndexesUsingBlock:^(NSUInteger geneIndex, BOOL *stop) {
+        values[geneIndex] = value;
+    }];
+    
+    if (_keyCount > 0 && [value isKindOfClass:[NSDictionary class]])
+    {
+        for (NSUInteger i = 0; i < _keyCount; i++)
+        {
+            id childValue = value[_keys[i]];
+            if (childValue)
+            {
+                [_keyChildren[i] assignValue:childValue values:values];
+            }
+        }
+    }
+    else if (_keyCount > 0 && [value isKindOfClass:[NSArray class]])
+    {
+        for (NSUInteger i = 0; i < _keyCount; i++)
+        {
+            [_keyChildren[i] assignValue:[value valueForKey:_keys[i]] values:values];
+        }
+    }
+    
+    if (_indexChildren.count > 0 && [value isKindOfClass:[NSArray class]])
+    {
+        NSUInteger count = [value count];
+        [_indexChildren enumerateKeysAndObjectsUsingBlock:^(NSNumber *index, _GNKJSONPathNode *child, BOOL *stop) {
+            if (index.unsignedIntegerValue < count)
+            {
+                [child assignValue:value[index.unsignedIntegerValue] values:values];
+            }
+        }];
+    }
+}
+
+@end
+
+/**
+ *  Scans the value at the current position, assigning any values which lead to genes. Values which no gene needs are skipped, as are values whose type does not match the node's path.
+ */
+static BOOL GNKJSONMatchValue(GNKJSONScanner *scanner, _GNKJSONPathNode *node, __strong id *values, NSError **error)
+{
+    int byte = GNKJSONPeek(scanner);
+    
+    // Key paths which pass through an array map over its elements, so the array is materialized and mapped exactly as key-value coding would.
+    if (node->_geneIndexes.count > 0 || (byte == '[' && node->_keyCount > 0))
+    {
+        id value = GNKJSONScanValue(scanner, error);
+        if (!value)
+        {
+            return NO;
+        }
+        
+        [node assignValue:value values:values];
+        return YES;
+    }
+    else if (byte == '{' && node->_keyCount > 0)
+    {
+        scanner->position++;
+        
+        if (GNKJSONScanByte(scanner, '}'))
+        {
+            return YES;
+        }
+        
+        do
+        {
+            NSRange range;
+            BOOL hasEscapes;
+            if (!GNKJSONScanStringRange(scanner, &range, &hasEscapes) || !GNKJSONScanByte(scanner, ':'))
+            {
+                return GNKJSONFail(scanner, error);
+            }
+            
+            _GNKJSONPathNode *child;
+            if (!hasEscapes)
+            {
+                child = [node childForKeyBytes:(scanner->bytes + range.location) length:range.length];
+            }
+            else
+            {
+                NSData *keyData = GNKJSONUnescapedData(scanner->bytes, range, hasEscapes);
+                if (!keyData)
+                {
+                    return GNKJSONFail(scanner, error);
+                }
+                
+                child = [node childForKeyBytes:keyData.bytes length:keyData.length];
+            }
+            
+            if (child)
+            {
+                if (!GNKJSONMatchValue(scanner, child, values, error))
+                {
+                    return NO;
+                }
+            }
+            else if (!GNKJSONSkipValue(scanner))
+            {
+                return GNKJSONFail(scanner, error);
+            }
+        }
+        while (GNKJSONScanByte(scanner, ','));
+        
+        if (!GNKJSONScanByte(scanner, '}'))
+        {
+            return GNKJSONFail(scanner, error);
+        }
+        
+        return YES;
+    }
+    else if (byte == '[' && node->_indexChildren.count > 0)
+    {
+        scanner->position++;
+        
+        if (GNKJSONScanByte(scanner, ']'))
+        {
+            return YES;
+        }
+        
+        NSUInteger index = 0;
+        do
+        {
+            _GNKJSONPathNode *child = (index <= node->_maximumIndex) ? node->_indexChildren[@(index)] : nil;
+            if (child)
+            {
+                if (!GNKJSONMatchValue(scanner, child, values, error))
+                {
+                    return NO;
+                }
+            }
+            else if (!GNKJSONSkipValue(scanner))
+            {
+                return GNKJSONFail(scanner, error);
+            }
+            
+            index++;
+        }
+        while (GNKJSONScanByte(scanner, ','));
+        
+        if (!GNKJSONScanByte(scanner, ']'))
+        {
+            return GNKJSONFail(scanner, error);
+        }
+        
+        return YES;
+    }
+    
+    if (!GNKJSONSkipValue(scanner))
+    {
+        return GNKJSONFail(scanner, error);
+    }
+    
+    return YES;
+}
+
+
+#pragma mark - GNKJSONMatcher
+
+@implementation GNKJSONMatcher
+{
+    _GNKJSONPathNode *_root;
+    NSUInteger _geneCount;
+}
+
++ (instancetype)matcherWithGenome:(GNKGenome *)genome
+{
+    NSParameterAssert(genome);
+    
+    _GNKJSONPathNode *root = [_GNKJSONPathNode new];
+    const GNKGenomeEntry *entries = genome.entries;
+    
+    for (NSUInteger i = 0; i < genome.count; i++)
+    {
+        NSArray *components = GNKTraitPathComponents(entries[i].sourceTrait);
+        if (components.count == 0)
+        {
+            return nil;
+        }
+        
+        _GNKJSONPathNode *node = root;
+        for (id component in components)
+        {
+            node = [node addChildForComponent:component];
+        }
+        
+        [node addGeneIndex:i];
+    }
+    
+    [root finishBuilding];
+    
+    return [[self alloc] initWithRoot:root geneCount:genome.count];
+}
+
+- (instancetype)initWithRoot:(_GNKJSONPathNode *)root geneCount:(NSUInteger)geneCount
+{
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    _root = root;
+    _geneCount = geneCount;
+    
+    return self;
+}
+
+- (BOOL)matchValuesInData:(NSData *)data values:(__strong id *)values error:(NSError **)error
+{
+    NSParameterAssert(data);
+    NSParameterAssert(values);
+    
+    GNKJSONScanner scanner = { data.bytes, data.length, 0 };
+    
+    if (!GNKJSONMatchValue(&scanner, _root, values, error))
+    {
+        return NO;
+    }
+    
+    GNKJSONSkipWhitespace(&scanner);
+    return (scanner.position == scanner.length) ?: GNKJSONFail(&scanner, error);
+}
+
+- (BOOL)matchValuesOfElementsInData:(NSData *)data values:(__strong id *)values usingBlock:(void (^)(NSUInteger))block error:(NSError **)error
+{
+    NSParameterAssert(data);
+    NSParameterAssert(values);
+    NSParameterAssert(block);
+    
+    GNKJSONScanner scanner = { data.bytes, data.length, 0 };
+    
+    if (!GNKJSONScanByte(&scanner, '['))
+    {
+        return GNKJSONFail(&scanner, error);
+    }
+    
+    if (!GNKJSONScanByte(&scanner, ']'))
+    {
+        NSUInteger index = 0;
+        
+        do
+        {
+            BOOL matched;
+            NSError *matchError;
+            
+            // Each element's temporary values are released before scanning the next one. The error is held strongly so it outlives the pool.
+            @autoreleasepool
+            {
+                matched = GNKJSONMatchValue(&scanner, _root, values, &matchError);
+                
+                if (matched)
+                {
+                    block(index);
+                }
+                
+                for (NSUInteger i = 0; i < _geneCount; i++)
+                {
+                    values[i] = nil;
+                }
+            }
+            
+            if (!matched)
+            {
+                if (error)
+                {
+                    *error = matchError;
+                }
+                
+                return NO;
+            }
+            
+            index++;
+        }
+        while (GNKJSONScanByte(&scanner, ','));
+        
+        if (!GNKJSONScanByte(&scanner, ']'))
+        {
+            return GNKJSONFail(&scanner, error);
+        }
+    }
+    
+    GNKJSONSkipWhitespace(&scanner);
+    return (scanner.position == scanner.length) ?: GNKJSONFail(&scanner, error);
+}
+
+@end
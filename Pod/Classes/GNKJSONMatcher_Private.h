@@ -0,0 +1,52 @@
+//
+//  GNKJSONMatcher_Private.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/27/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class GNKGenome;
+
+/**
+ *  A GNKJSONMatcher finds the source values of a genome's genes directly in JSON data, without parsing the data into a tree of collections.
+ *
+ *  The path of each gene's source trait is compiled into a trie. While scanning the data, only values whose path leads to a gene are parsed; every other value is skipped without being materialized. Values which a gene needs in their entirety, such as a nested object, are parsed with NSJSONSerialization from the range of bytes they occupy.
+ */
+@interface GNKJSONMatcher : NSObject
+
+/**
+ *  Compiles a matcher for the genome.
+ *
+ *  @param genome The genome whose source traits to match.
+ *
+ *  @return A new matcher, or nil if any gene's source trait cannot be expressed as a path through JSON.
+ */
++ (instancetype)matcherWithGenome:(GNKGenome *)genome __attribute((nonnull));
+
+/**
+ *  Finds the source values for a single JSON document.
+ *
+ *  @param data   The JSON data to scan.
+ *  @param values A buffer with room for one value per gene in the genome, which must be empty. Each value is set to the value found for the gene at the same position, or left nil if none was found.
+ *  @param error  On return, the reason the data is invalid if NO was returned.
+ *
+ *  @return YES if the data was scanned, NO if it is not valid JSON.
+ */
+- (BOOL)matchValuesInData:(NSData *)data values:(__strong id *)values error:(NSError **)error;
+
+/**
+ *  Finds the source values for each element of a JSON document whose top level value is an array.
+ *
+ *  @param data   The JSON data to scan.
+ *  @param values A buffer with room for one value per gene in the genome, which must be empty. The buffer is filled for each element before the block is invoked, and emptied afterwards.
+ *  @param block  The block to invoke after the values of each element are found, with the position of the element.
+ *  @param error  On return, the reason the data is invalid if NO was returned.
+ *
+ *  @return YES if the data was scanned, NO if it is not valid JSON or its top level value is not an array.
+ */
+- (BOOL)matchValuesOfElementsInData:(NSData *)data values:(__strong id *)values usingBlock:(void (^)(NSUInteger index))block error:(NSError **)error;
+
+@end
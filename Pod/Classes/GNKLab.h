@@ -8,6 +8,8 @@
 
 #import <Foundation/Foundation.h>
 
+@class GNKGenome, GNKPatch;
+
 /**
  *  A bitmask of possible options when transfering or comparing objects.
  */
@@ -32,10 +34,34 @@ typedef NS_OPTIONS(NSInteger, GNKLabOptions)
     /**
      *  Indicates that `[NSNull null]` source values should not be converted into `nil` immediately prior to setting them on the receiver.
      */
-    GNKLabSkipPreSettingNilConversion = 1 << 3
+    GNKLabSkipPreSettingNilConversion = 1 << 3,
+    /**
+     *  Indicates that the source values of genes whose transformers conform to GNKExpensiveValueTransformer should be retrieved and transformed concurrently before any value is set on the receiver. Values are still set on the calling thread in the genome's order, so the results are the same as without this option, provided the source can be read from many threads at once and is not the receiver. This option only applies to the methods which transfer traits from a single source object, and is ignored when fewer than two genes are expensive. If a transformer raises an exception, the first one raised is re-raised on the calling thread once every expensive gene has been evaluated, and no value is set.
+     */
+    GNKLabEvaluateExpensiveGenesConcurrently = 1 << 4,
+    /**
+     *  Indicates that each receiving trait value should be retrieved before setting it, and that the value should only be set if it is not equal to the value about to be set, compared as when finding genes with different traits. Values are compared after `[NSNull null]` is converted into `nil`, so a `nil` receiving value is not set again. Receivers which conform to GNKChangeBatchingReceiver are told when the changed values begin and end being set. Note that scalar values are boxed in order to compare them, and that batch transformers transform values for a single receiver at a time with this option.
+     */
+    GNKLabSkipUnchangedValues = 1 << 5
 };
 
 
+/**
+ *  The error domain for errors returned by GNKLab.
+ */
+FOUNDATION_EXTERN NSString *const GNKLabErrorDomain;
+
+/**
+ *  Error codes within the GNKLabErrorDomain.
+ */
+typedef NS_ENUM(NSInteger, GNKLabErrorCode)
+{
+    /**
+     *  Indicates that JSON data could not be parsed, or did not have the expected top level value.
+     */
+    GNKLabErrorInvalidJSON = 1
+};
+
 /**
  *  Collection of utilities which operate using GNKGene objects to compare and transfer trait values.
  *
@@ -86,4 +112,196 @@ typedef NS_OPTIONS(NSInteger, GNKLabOptions)
  */
 + (NSSet *)findGenesWithDifferentTraitsFromSource:(id)source receiver:(id)receiver genome:(NSArray *)genome options:(GNKLabOptions)options __attribute((nonnull));
 
+/**
+ *  Method which transfers traits from the source object to the receiver object using a prebuilt GNKGenome.
+ *
+ *  This behaves exactly like -transferTraitsFromSource:receiver:genome:options:, but because the genome has already been validated and deduplicated no collections are built while transfering. Prefer this method when the same genome is used for many transfers.
+ *
+ *  @see transferTraitsFromSource:receiver:genome:options:
+ *
+ *  @param source   The source object which will provide trait values. This must not be nil.
+ *  @param receiver The receiving object which will have values set on it. This must not be nil.
+ *  @param genome   The genome to follow for retrieving and setting values from the source to the receiver. This must not be nil.
+ *  @param options  A bitmask of options to use when transfering traits.
+ */
++ (void)transferTraitsFromSource:(id)source receiver:(id)receiver compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options __attribute((nonnull));
+
+/**
+ *  Method which compares trait values between objects using a prebuilt GNKGenome and finds the genes which do not share common values.
+ *
+ *  This behaves exactly like -findGenesWithDifferentTraitsFromSource:receiver:genome:options:, but because the genome has already been validated and deduplicated no collections are built except for the returned set.
+ *
+ *  @see findGenesWithDifferentTraitsFromSource:receiver:genome:options:
+ *
+ *  @param source   The source object which will provide trait values to compare with. This must not be nil.
+ *  @param receiver The receiving object which will have its trait values compared against. This must not be nil.
+ *  @param genome   The genome to follow for retrieving values from the source and receiver. This must not be nil.
+ *  @param options  A bitmask of options to use when retrieving traits. Note that the GNKLabPreSettingNilConversion option is ignored.
+ *
+ *  @return A set of GNKGene objects which have traits that did not represent equivalent values between the source and receiver.
+ */
++ (NSSet *)findGenesWithDifferentTraitsFromSource:(id)source receiver:(id)receiver compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options __attribute((nonnull));
+
+/**
+ *  Method which checks if any trait values differ between objects using a prebuilt GNKGenome.
+ *
+ *  Genes are compared in the same way as -findGenesWithDifferentTraitsFromSource:receiver:compiledGenome:options:, but the comparison stops at the first gene with different values and no collections are built. Prefer this method when only whether the objects differ matters.
+ *
+ *  @param source   The source object which will provide trait values to compare with. This must not be nil.
+ *  @param receiver The receiving object which will have its trait values compared against. This must not be nil.
+ *  @param genome   The genome to follow for retrieving values from the source and receiver. This must not be nil.
+ *  @param options  A bitmask of options to use when retrieving traits. Note that the GNKLabPreSettingNilConversion option is ignored.
+ *
+ *  @return YES if any gene has traits that did not represent equivalent values between the source and receiver, NO if all of them did.
+ */
++ (BOOL)hasDifferentTraitsFromSource:(id)source receiver:(id)receiver compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options __attribute((nonnull));
+
+/**
+ *  Method which compares trait values between objects using a prebuilt GNKGenome and finds the positions of the genes which do not share common values.
+ *
+ *  Genes are compared in the same way as -findGenesWithDifferentTraitsFromSource:receiver:compiledGenome:options:, but the genes are identified by their index in the genome rather than collected into a set, so no genes are hashed.
+ *
+ *  @param source   The source object which will provide trait values to compare with. This must not be nil.
+ *  @param receiver The receiving object which will have its trait values compared against. This must not be nil.
+ *  @param genome   The genome to follow for retrieving values from the source and receiver. This must not be nil.
+ *  @param options  A bitmask of options to use when retrieving traits. Note that the GNKLabPreSettingNilConversion option is ignored.
+ *
+ *  @return The indexes of the genes in the genome which have traits that did not represent equivalent values between the source and receiver. This is empty if all traits were equivalent.
+ */
++ (NSIndexSet *)indexesOfGenesWithDifferentTraitsFromSource:(id)source receiver:(id)receiver compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options __attribute((nonnull));
+
+/**
+ *  Method which compares trait values between objects using a prebuilt GNKGenome and captures the genes which do not share common values, along with their source values, in a patch.
+ *
+ *  Genes are compared in the same way as -findGenesWithDifferentTraitsFromSource:receiver:compiledGenome:options:. The source value of each gene which differs is kept in the patch after it has been transformed, so applying the patch later does not read the source or run any transformer again. Prefer this method over finding the different genes and then transfering them when both are needed.
+ *
+ *  @see applyPatch:toReceiver:
+ *
+ *  @param source   The source object which will provide trait values to compare with. This must not be nil.
+ *  @param receiver The receiving object which will have its trait values compared against. This must not be nil.
+ *  @param genome   The genome to follow for retrieving values from the source and receiver. This must not be nil.
+ *  @param options  A bitmask of options to use when retrieving traits, which are also used when the patch is applied.
+ *
+ *  @return A patch of the genes which have traits that did not represent equivalent values between the source and receiver. The patch is empty if all traits were equivalent.
+ */
++ (GNKPatch *)patchWithDifferentTraitsFromSource:(id)source receiver:(id)receiver compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options __attribute((nonnull));
+
+/**
+ *  Method which sets the values captured in a patch on the receiver object.
+ *
+ *  Each value is set exactly as -transferTraitsFromSource:receiver:compiledGenome:options: would set it after retrieving and transforming it, using the options the patch was created with, and in the order of the genome. The patch is not modified, so it may be applied to many receivers, including from several threads at once.
+ *
+ *  @see patchWithDifferentTraitsFromSource:receiver:compiledGenome:options:
+ *
+ *  @param patch    The patch to apply. This must not be nil.
+ *  @param receiver The receiving object which will have values set on it. This must not be nil.
+ */
++ (void)applyPatch:(GNKPatch *)patch toReceiver:(id)receiver __attribute((nonnull));
+
+/**
+ *  Method which transfers traits from each source object to the receiver object at the same position, spreading the work across all available cores.
+ *
+ *  The pairs of sources and receivers are split into chunks which are processed concurrently. Each chunk is wrapped in its own autorelease pool so that temporary values are released as soon as the chunk finishes. Each individual pair is transfered exactly as if -transferTraitsFromSource:receiver:compiledGenome:options: had been called, however pairs are not necessarily processed in order. This method does not return until every pair has been processed. If a transfer raises an exception, the remaining pairs of its chunk are skipped, and once every chunk has finished the first exception raised is re-raised on the calling thread.
+ *
+ *  Because pairs are processed concurrently, the source objects must be safe to read from multiple threads, and no receiver may appear more than once.
+ *
+ *  If any gene's transformer conforms to GNKBatchValueTransformer, that gene's source values are gathered for every pair in a chunk and transformed in a single call before being set on the receivers. Genes are still set on each receiver in the order of the genome. Subclasses which override +transferTraitsFromSource:receiver:compiledGenome:options: have that method called for each pair instead, so batch transformers are then called once per value.
+ *
+ *  @see transferTraitsFromSource:receiver:compiledGenome:options:
+ *
+ *  @param sources   An array of source objects which will provide trait values. This must not be nil.
+ *  @param receivers An array of receiving objects which will have values set on them. This must contain the same number of objects as the sources array.
+ *  @param genome    The genome to follow for retrieving and setting values from each source to its receiver. This must not be nil.
+ *  @param options   A bitmask of options to use when transfering traits.
+ *  @param chunkSize The number of pairs processed together on a single thread. Pass 0 to have a chunk size chosen based on the number of pairs and the number of active processors.
+ */
++ (void)transferTraitsFromSources:(NSArray *)sources receivers:(NSArray *)receivers compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options chunkSize:(NSUInteger)chunkSize __attribute((nonnull));
+
+/**
+ *  Method which creates a receiver for each source object using the given factory, then transfers traits from each source object to its receiver, spreading the work across all available cores.
+ *
+ *  This behaves like -transferTraitsFromSources:receivers:compiledGenome:options:chunkSize:, except that the receiver factory is invoked for each source object just before the traits of its chunk are transfered. Note that the factory will be invoked concurrently from multiple threads.
+ *
+ *  @see transferTraitsFromSources:receivers:compiledGenome:options:chunkSize:
+ *
+ *  @param sources         An array of source objects which will provide trait values. This must not be nil.
+ *  @param genome          The genome to follow for retrieving and setting values from each source to its receiver. This must not be nil.
+ *  @param options         A bitmask of options to use when transfering traits.
+ *  @param chunkSize       The number of sources processed together on a single thread. Pass 0 to have a chunk size chosen based on the number of sources and the number of active processors.
+ *  @param receiverFactory A block which returns a new receiving object for the given source object. The block must not return nil, and an NSInvalidArgumentException is raised on the calling thread if it does. This must not be nil.
+ *
+ *  @return An array of the created receivers, in the same order as the sources array.
+ */
++ (NSArray *)receiversByTransferringTraitsFromSources:(NSArray *)sources compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options chunkSize:(NSUInteger)chunkSize receiverFactory:(id (^)(id source))receiverFactory __attribute((nonnull));
+
+/**
+ *  Method which transfers traits from a JSON document to the receiver object using a prebuilt GNKGenome, without parsing the document into collections.
+ *
+ *  The paths of the genome's source traits are matched against the document as it is scanned. Only values which a gene reads are parsed, and every other value is skipped without being materialized, so the peak memory used is proportional to the values read rather than the size of the document. For large documents, pass data read with NSDataReadingMappedIfSafe to avoid loading the document into memory at all.
+ *
+ *  Once the document has been scanned, the values found are transfered as -transferTraitsFromSource:receiver:compiledGenome:options: would transfer them from the document parsed by NSJSONSerialization. A key path which passes through an array maps its remaining keys over the array's elements, as key-value coding does. Unlike key-value coding, values which are missing from the document, or which are strings, numbers or literals where the path expects a container, are treated as `nil` rather than raising an exception. If any gene's source trait cannot be matched as a path, such as an aggregate or identity trait, the document is parsed with NSJSONSerialization instead.
+ *
+ *  @see transferTraitsFromSource:receiver:compiledGenome:options:
+ *
+ *  @param data     The JSON document which will provide trait values. This must not be nil.
+ *  @param receiver The receiving object which will have values set on it. This must not be nil.
+ *  @param genome   The genome to follow for retrieving and setting values from the document to the receiver. This must not be nil.
+ *  @param options  A bitmask of options to use when transfering traits.
+ *  @param error    On return, the reason the document could not be read if NO was returned.
+ *
+ *  @return YES if the traits were transfered, NO if the document is not valid JSON. Nothing is set on the receiver if NO is returned.
+ */
++ (BOOL)transferTraitsFromJSONData:(NSData *)data receiver:(id)receiver compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options error:(NSError **)error;
+
+/**
+ *  Method which creates a receiver for each element of a JSON document whose top level value is an array, then transfers traits from each element to its receiver, without parsing the document into collections.
+ *
+ *  Each element is matched and transfered as it is scanned, exactly as -transferTraitsFromJSONData:receiver:compiledGenome:options:error: would for a document containing only that element, so only the values of a single element are held in memory at a time.
+ *
+ *  @see transferTraitsFromJSONData:receiver:compiledGenome:options:error:
+ *
+ *  @param data            The JSON document which will provide trait values. This must not be nil.
+ *  @param genome          The genome to follow for retrieving and setting values from each element to its receiver. This must not be nil.
+ *  @param options         A bitmask of options to use when transfering traits.
+ *  @param receiverFactory A block invoked with the position of each element, which must return a new receiving object. This must not be nil.
+ *  @param error           On return, the reason the document could not be read if nil was returned.
+ *
+ *  @return An array of the receivers created by the factory, in the same order as the elements of the document, or nil if the document is not valid JSON or is not an array.
+ */
++ (NSArray *)receiversByTransferringTraitsFromJSONData:(NSData *)data compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options receiverFactory:(id (^)(NSUInteger index))receiverFactory error:(NSError **)error;
+
+/**
+ *  Enables or disables instrumentation. Instrumentation is disabled by default.
+ *
+ *  While instrumentation is enabled, every transfer records how many times each gene was transfered, how many of those transfers were skipped because the value was `nil` or retrieved `[NSNull null]`, and how long was spent in the gene's transformer and setting values on the receiver. Each thread records into its own counters, so concurrent transfers do not contend with each other. Use +geneStatistics to combine the counters recorded so far.
+ *
+ *  While instrumentation is disabled, transfers only pay for a single predictable branch. Comparisons of traits are never instrumented.
+ *
+ *  @param instrumentationEnabled YES to enable instrumentation, NO to disable it.
+ */
++ (void)setInstrumentationEnabled:(BOOL)instrumentationEnabled;
+
+/**
+ *  Checks if instrumentation is enabled.
+ *
+ *  @see setInstrumentationEnabled:
+ *
+ *  @return YES if instrumentation is enabled, NO if it is not.
+ */
++ (BOOL)isInstrumentationEnabled;
+
+/**
+ *  Combines the counters recorded by every thread since instrumentation was first enabled, or since they were last reset. Counters are kept while instrumentation is disabled.
+ *
+ *  @see setInstrumentationEnabled:
+ *
+ *  @return An array of GNKGeneStatistics, one for each distinct gene transfered while instrumentation was enabled, ordered from the most to the least time spent in its transformer and setter.
+ */
++ (NSArray *)geneStatistics;
+
+/**
+ *  Discards the counters recorded by every thread.
+ */
++ (void)resetGeneStatistics;
+
 @end
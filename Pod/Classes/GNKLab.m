@@ -6,84 +6,1306 @@
 //  Copyright (c) 2015 Zach Radke. All rights reserved.
 //
 
-#import "GNKLab.h"
+#import "GNKLab_Private.h"
 #import "GNKGene.h"
-#import "GNKTrait.h"
+#import "GNKTrait_Private.h"
+#import "GNKBatchValueTransformer.h"
+#import "GNKChangeBatchingReceiver.h"
+#import "GNKJSONMatcher_Private.h"
+#import "GNKGeneStatistics_Private.h"
+#import "GNKLabProgram_Private.h"
+#import "GNKPatch_Private.h"
 
-static id GNKTraitValue(id object, id<GNKSourceTrait> trait, NSValueTransformer *transformer, GNKLabOptions options)
+NSString *const GNKLabErrorDomain = @"com.zachradke.GeneticsKit.lab";
+
+static id GNKTransformedTraitValue(id value, NSValueTransformer *transformer, BOOL reversesTransformer, GNKLabOptions options)
+{
+    if ((!(options & GNKLabUseNilValues) && !value) || !transformer)
+    {
+        return value;
+    }
+    
+    if (!(options & GNKLabSkipPreTranformationNilConversion) && value == [NSNull null])
+    {
+        value = nil;
+    }
+    
+    value = reversesTransformer ? [transformer reverseTransformedValue:value] : [transformer transformedValue:value];
+    
+    if (!(options & GNKLabSkipPostTranformationNullConversion) && !value)
+    {
+        value = [NSNull null];
+    }
+    
+    return value;
+}
+
+static id GNKTraitValue(id object, id<GNKSourceTrait> trait, NSValueTransformer *transformer, BOOL reversesTransformer, GNKLabOptions options)
+{
+    return GNKTransformedTraitValue([trait traitValueFromObject:object], transformer, reversesTransformer, options);
+}
+
+/**
+ *  Sets an already transformed value exactly as GNKLabSetValue does, while recording statistics for the entry's gene.
+ */
+static void GNKLabSetValueInstrumented(id sourceValue, id receiver, const GNKGenomeEntry *entry, GNKLabOptions options, NSUInteger nullCount, uint64_t transformerTime)
+{
+    if (!(options & GNKLabUseNilValues) && !sourceValue)
+    {
+        GNKGeneStatisticsRecord(entry->gene, 1, 1, nullCount, transformerTime, 0);
+        return;
+    }
+    
+    if (!(options & GNKLabSkipPreSettingNilConversion) && sourceValue == [NSNull null])
+    {
+        sourceValue = nil;
+    }
+    
+    uint64_t setterStart = GNKGeneStatisticsTime();
+    [entry->receivingTrait setTraitValue:sourceValue onObject:receiver];
+    GNKGeneStatisticsRecord(entry->gene, 1, 0, nullCount, transformerTime, GNKGeneStatisticsTime() - setterStart);
+}
+
+/**
+ *  Transforms a value exactly as GNKTransformedTraitValue does, while recording the transformer time for the entry's gene.
+ */
+static id GNKTransformedTraitValueInstrumented(id value, const GNKGenomeEntry *entry, GNKLabOptions options, uint64_t *transformerTime)
+{
+    if (!entry->transformer)
+    {
+        *transformerTime = 0;
+        return value;
+    }
+    
+    uint64_t transformerStart = GNKGeneStatisticsTime();
+    value = GNKTransformedTraitValue(value, entry->transformer, entry->reversesTransformer, options);
+    *transformerTime = GNKGeneStatisticsTime() - transformerStart;
+    
+    return value;
+}
+
+/**
+ *  Transfers a value exactly as GNKLabApplyValue does, while recording statistics for the entry's gene.
+ */
+static void GNKLabTransferValueInstrumented(id value, id receiver, const GNKGenomeEntry *entry, GNKLabOptions options)
+{
+    NSUInteger nullCount = (value == [NSNull null]) ? 1 : 0;
+    uint64_t transformerTime;
+    
+    id sourceValue = GNKTransformedTraitValueInstrumented(value, entry, options, &transformerTime);
+    GNKLabSetValueInstrumented(sourceValue, receiver, entry, options, nullCount, transformerTime);
+}
+
+/**
+ *  Transfers an entry exactly as GNKLabTransferEntry does, while recording statistics for the entry's gene. Copied scalar values are recorded entirely as setter time.
+ */
+static void GNKLabTransferEntryInstrumented(id source, id receiver, const GNKGenomeEntry *entry, GNKLabOptions options)
+{
+    if (entry->copiesScalarValues)
+    {
+        uint64_t setterStart = GNKGeneStatisticsTime();
+        
+        if (GNKTraitCopyScalarValue(entry->sourceTrait, source, entry->receivingTrait, receiver))
+        {
+            GNKGeneStatisticsRecord(entry->gene, 1, 0, 0, 0, GNKGeneStatisticsTime() - setterStart);
+            return;
+        }
+    }
+    
+    GNKLabTransferValueInstrumented([entry->sourceTrait traitValueFromObject:source], receiver, entry, options);
+}
+
+/**
+ *  Sets a value which has already been transformed for a single entry on the receiver.
+ */
+static inline void GNKLabSetValue(id sourceValue, id receiver, const GNKGenomeEntry *entry, GNKLabOptions options)
+{
+    if (!(options & GNKLabUseNilValues) && !sourceValue)
+    {
+        return;
+    }
+    
+    if (!(options & GNKLabSkipPreSettingNilConversion) && sourceValue == [NSNull null])
+    {
+        sourceValue = nil;
+    }
+    
+    [entry->receivingTrait setTraitValue:sourceValue onObject:receiver];
+}
+
+/**
+ *  Transforms a value retrieved from a source object for a single entry and sets it on the receiver.
+ */
+static inline void GNKLabApplyValue(id value, id receiver, const GNKGenomeEntry *entry, GNKLabOptions options)
+{
+    GNKLabSetValue(GNKTransformedTraitValue(value, entry->transformer, entry->reversesTransformer, options), receiver, entry, options);
+}
+
+/**
+ *  Compares a source value with a receiving value. This is the comparison used both when finding genes with different traits and when skipping unchanged values.
+ */
+static inline BOOL GNKLabValuesAreEqual(id sourceValue, id receivingValue)
+{
+    return (!sourceValue && !receivingValue) || (sourceValue && [receivingValue isEqual:sourceValue]);
+}
+
+/**
+ *  Sets a value which has already been transformed for a single entry only if it differs from the receiver's value, recording statistics if instrumentation is enabled. If changesBegan is not NULL, the receiver batches its changes, and is told they will begin before the first value is set.
+ */
+static void GNKLabSetChangedValue(id sourceValue, id receiver, const GNKGenomeEntry *entry, GNKLabOptions options, BOOL *changesBegan, NSUInteger nullCount, uint64_t transformerTime)
+{
+    BOOL instrumented = __builtin_expect(GNKGeneStatisticsEnabled, NO);
+    
+    if (!(options & GNKLabUseNilValues) && !sourceValue)
+    {
+        if (instrumented)
+        {
+            GNKGeneStatisticsRecord(entry->gene, 1, 1, nullCount, transformerTime, 0);
+        }
+        
+        return;
+    }
+    
+    if (!(options & GNKLabSkipPreSettingNilConversion) && sourceValue == [NSNull null])
+    {
+        sourceValue = nil;
+    }
+    
+    // The value is compared after conversion, so a value which sets nil is unchanged when the receiver's value is already nil.
+    if (GNKLabValuesAreEqual(sourceValue, [entry->receivingTrait traitValueFromObject:receiver]))
+    {
+        if (instrumented)
+        {
+            GNKGeneStatisticsRecord(entry->gene, 1, 1, nullCount, transformerTime, 0);
+        }
+        
+        return;
+    }
+    
+    if (changesBegan && !*changesBegan)
+    {
+        [(id<GNKChangeBatchingReceiver>)receiver willChangeTraits];
+        *changesBegan = YES;
+    }
+    
+    uint64_t setterStart = instrumented ? GNKGeneStatisticsTime() : 0;
+    [entry->receivingTrait setTraitValue:sourceValue onObject:receiver];
+    
+    if (instrumented)
+    {
+        GNKGeneStatisticsRecord(entry->gene, 1, 0, nullCount, transformerTime, GNKGeneStatisticsTime() - setterStart);
+    }
+}
+
+/**
+ *  Transforms a value retrieved from a source object for a single entry and sets it on the receiver only if it differs from the receiver's value.
+ */
+static void GNKLabTransferChangedValue(id value, id receiver, const GNKGenomeEntry *entry, GNKLabOptions options, BOOL *changesBegan)
+{
+    NSUInteger nullCount = (value == [NSNull null]) ? 1 : 0;
+    uint64_t transformerTime = 0;
+    
+    if (__builtin_expect(GNKGeneStatisticsEnabled, NO))
+    {
+        value = GNKTransformedTraitValueInstrumented(value, entry, options, &transformerTime);
+    }
+    else
+    {
+        value = GNKTransformedTraitValue(value, entry->transformer, entry->reversesTransformer, options);
+    }
+    
+    GNKLabSetChangedValue(value, receiver, entry, options, changesBegan, nullCount, transformerTime);
+}
+
+BOOL GNKLabBatchesChanges(id receiver, GNKLabOptions options)
+{
+    return (options & GNKLabSkipUnchangedValues) && [receiver conformsToProtocol:@protocol(GNKChangeBatchingReceiver)];
+}
+
+static void GNKLabTransferValue(id value, id receiver, const GNKGenomeEntry *entry, GNKLabOptions options, BOOL *changesBegan)
+{
+    if (options & GNKLabSkipUnchangedValues)
+    {
+        GNKLabTransferChangedValue(value, receiver, entry, options, changesBegan);
+        return;
+    }
+    
+    if (__builtin_expect(GNKGeneStatisticsEnabled, NO))
+    {
+        GNKLabTransferValueInstrumented(value, receiver, entry, options);
+        return;
+    }
+    
+    GNKLabApplyValue(value, receiver, entry, options);
+}
+
+void GNKLabTransferEntry(id source, id receiver, const GNKGenomeEntry *entry, GNKLabOptions options, BOOL *changesBegan)
+{
+    // Scalar values are copied without reading the receiver's value, so they are boxed in order to compare them.
+    if (options & GNKLabSkipUnchangedValues)
+    {
+        GNKLabTransferChangedValue([entry->sourceTrait traitValueFromObject:source], receiver, entry, options, changesBegan);
+        return;
+    }
+    
+    // Instrumentation costs a single branch per gene while it is disabled.
+    if (__builtin_expect(GNKGeneStatisticsEnabled, NO))
+    {
+        GNKLabTransferEntryInstrumented(source, receiver, entry, options);
+        return;
+    }
+    
+    // Scalar values are never nil or NSNull, so none of the options apply to them.
+    if (entry->copiesScalarValues && GNKTraitCopyScalarValue(entry->sourceTrait, source, entry->receivingTrait, receiver))
+    {
+        return;
+    }
+    
+    GNKLabApplyValue([entry->sourceTrait traitValueFromObject:source], receiver, entry, options);
+}
+
+/**
+ *  Keeps the first exception caught by concurrent work. The slot holds a retained reference and is only ever exchanged from NULL, so later exceptions are released. Pass the slot to GNKLabTakeException once the concurrent work has finished.
+ */
+static void GNKLabRecordException(void **firstException, id exception)
+{
+    void *expected = NULL;
+    void *retainedException = (__bridge_retained void *)exception;
+    
+    if (!__atomic_compare_exchange_n(firstException, &expected, retainedException, NO, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        (void)(__bridge_transfer id)retainedException;
+    }
+}
+
+/**
+ *  Returns the exception kept by GNKLabRecordException, or nil if none was caught, releasing the slot's reference.
+ */
+static id GNKLabTakeException(void **firstException)
+{
+    id exception = (__bridge_transfer id)*firstException;
+    *firstException = NULL;
+    
+    return exception;
+}
+
+/**
+ *  Retrieves and transforms the source values of every entry which evaluates concurrently, using the values of the prefix nodes where possible. The values buffer must have room for one value per concurrent entry, in the same order as the genome's concurrent entry indexes.
+ *
+ *  An exception escaping a dispatch_apply block terminates the process, so exceptions are caught on the worker threads instead. The first one caught is returned so the caller can release its buffers and raise it on the calling thread, and nil is returned otherwise.
+ */
+static id GNKLabEvaluateConcurrentEntries(id source, __strong id const *nodeValues, GNKGenome *genome, GNKLabOptions options, __strong id *values)
+{
+    const GNKGenomeEntry *entries = genome.entries;
+    const NSUInteger *indexes = genome.concurrentEntryIndexes;
+    
+    __block void *firstException = NULL;
+    
+    dispatch_apply(genome.concurrentEntryCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        @autoreleasepool
+        {
+            @try
+            {
+                const GNKGenomeEntry *entry = &entries[indexes[i]];
+                id value = (entry->prefixNode != NSNotFound) ? nodeValues[entry->prefixNode] : [entry->sourceTrait traitValueFromObject:source];
+                
+                if (__builtin_expect(GNKGeneStatisticsEnabled, NO))
+                {
+                    // The transfer itself is recorded once the value is set on the calling thread.
+                    uint64_t transformerTime;
+                    NSUInteger nullCount = (value == [NSNull null]) ? 1 : 0;
+                    
+                    values[i] = GNKTransformedTraitValueInstrumented(value, entry, options, &transformerTime);
+                    GNKGeneStatisticsRecord(entry->gene, 0, 0, nullCount, transformerTime, 0);
+                }
+                else
+                {
+                    values[i] = GNKTransformedTraitValue(value, entry->transformer, entry->reversesTransformer, options);
+                }
+            }
+            @catch (id exception)
+            {
+                GNKLabRecordException(&firstException, exception);
+            }
+        }
+    });
+    
+    return GNKLabTakeException(&firstException);
+}
+
+/**
+ *  Evaluates the prefix nodes of the genome against the source, returning a buffer of their values which must be passed to GNKLabReleasePrefixNodeValues, or NULL if the genome has no prefix nodes.
+ */
+static __strong id *GNKLabEvaluatePrefixNodes(id source, GNKGenome *genome)
+{
+    NSUInteger nodeCount = genome.prefixNodeCount;
+    if (nodeCount == 0)
+    {
+        return NULL;
+    }
+    
+    const GNKGenomePrefixNode *nodes = genome.prefixNodes;
+    __strong id *nodeValues = (__strong id *)calloc(nodeCount, sizeof(id));
+    
+    for (NSUInteger i = 0; i < nodeCount; i++)
+    {
+        id object = (nodes[i].parent == NSNotFound) ? source : nodeValues[nodes[i].parent];
+        nodeValues[i] = [nodes[i].trait traitValueFromObject:object];
+    }
+    
+    return nodeValues;
+}
+
+static void GNKLabReleasePrefixNodeValues(__strong id *nodeValues, GNKGenome *genome)
+{
+    if (!nodeValues)
+    {
+        return;
+    }
+    
+    for (NSUInteger i = 0; i < genome.prefixNodeCount; i++)
+    {
+        nodeValues[i] = nil;
+    }
+    
+    free(nodeValues);
+}
+
+/**
+ *  Transfers every entry of the genome using a program compiled from it, which calls each step directly.
+ */
+static void GNKLabRunProgram(id source, id receiver, GNKGenome *genome, GNKLabProgram *program)
+{
+    __unsafe_unretained GNKLabStep const *steps = program.steps;
+    NSUInteger count = genome.count;
+    
+    if (genome.prefixNodeCount == 0)
+    {
+        for (NSUInteger i = 0; i < count; i++)
+        {
+            steps[i](source, receiver);
+        }
+        
+        return;
+    }
+    
+    const GNKGenomeEntry *entries = genome.entries;
+    __strong id *nodeValues = GNKLabEvaluatePrefixNodes(source, genome);
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        steps[i]((entries[i].prefixNode != NSNotFound) ? nodeValues[entries[i].prefixNode] : source, receiver);
+    }
+    
+    GNKLabReleasePrefixNodeValues(nodeValues, genome);
+}
+
+/**
+ *  Checks if every value of the genome can be set on the receiver directly rather than through its receiving traits, which is the case when the genome's receiving traits set distinct keys of a mutable dictionary or distinct indexes of a mutable array.
+ */
+static BOOL GNKLabSetsValuesInBulk(id receiver, GNKGenome *genome)
+{
+    switch (genome.receiverShape)
+    {
+        case GNKGenomeReceiverShapeKeys:
+            return [receiver isKindOfClass:[NSMutableDictionary class]];
+        case GNKGenomeReceiverShapeIndexes:
+            return [receiver isKindOfClass:[NSMutableArray class]];
+        case GNKGenomeReceiverShapeAny:
+            return NO;
+    }
+    
+    return NO;
+}
+
+/**
+ *  Transforms a value retrieved from a source object for a single entry and sets it directly on a mutable dictionary receiver, skipping key-value coding. Values are converted and skipped exactly as GNKLabSetValue would, and values which set nil remove their keys, exactly as -setValue:forKey: does.
+ */
+static inline void GNKLabApplyDictionaryValue(id value, NSMutableDictionary *receiver, const GNKGenomeEntry *entry, GNKLabOptions options)
+{
+    value = GNKTransformedTraitValue(value, entry->transformer, entry->reversesTransformer, options);
+    
+    if (!(options & GNKLabUseNilValues) && !value)
+    {
+        return;
+    }
+    
+    if (!(options & GNKLabSkipPreSettingNilConversion) && value == [NSNull null])
+    {
+        value = nil;
+    }
+    
+    if (value)
+    {
+        [receiver setObject:value forKey:entry->receivingKey];
+    }
+    else
+    {
+        [receiver removeObjectForKey:entry->receivingKey];
+    }
+}
+
+/**
+ *  Sets values which have already been transformed on a mutable array receiver. Values within the array replace their elements, and the array grows once to hold every value past its end, with NSNull in any holes, exactly as setting each index in turn would leave it.
+ */
+static void GNKLabSetArrayValues(__strong id const *values, const NSUInteger *indexes, NSUInteger count, NSMutableArray *receiver, const GNKGenomeEntry *entries)
+{
+    NSUInteger arrayCount = receiver.count;
+    NSUInteger length = arrayCount;
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        // Setting nil raises, so those values are set one at a time in the genome's order to raise exactly as they would have.
+        if (!values[i])
+        {
+            for (NSUInteger j = 0; j < count; j++)
+            {
+                [entries[indexes[j]].receivingTrait setTraitValue:values[j] onObject:receiver];
+            }
+            
+            return;
+        }
+        
+        length = MAX(length, entries[indexes[i]].receivingIndex + 1);
+    }
+    
+    if (length == arrayCount)
+    {
+        for (NSUInteger i = 0; i < count; i++)
+        {
+            receiver[entries[indexes[i]].receivingIndex] = values[i];
+        }
+        
+        return;
+    }
+    
+    __unsafe_unretained id *appendedObjects = (__unsafe_unretained id *)malloc((length - arrayCount) * sizeof(id));
+    id null = [NSNull null];
+    
+    for (NSUInteger i = 0; i < length - arrayCount; i++)
+    {
+        appendedObjects[i] = null;
+    }
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        NSUInteger index = entries[indexes[i]].receivingIndex;
+        
+        if (index < arrayCount)
+        {
+            receiver[index] = values[i];
+        }
+        else
+        {
+            appendedObjects[index - arrayCount] = values[i];
+        }
+    }
+    
+    [receiver addObjectsFromArray:[NSArray arrayWithObjects:appendedObjects count:(length - arrayCount)]];
+    free(appendedObjects);
+}
+
+/**
+ *  Transforms a value retrieved from a source object for every entry of the genome, then sets them on a mutable dictionary or array receiver without key-value coding. Dictionary keys are set one at a time, and arrays are grown once to hold every value. Values are converted and skipped exactly as GNKLabSetValue would, and the receiver is left exactly as setting each value in the genome's order would leave it. The receiver must have been checked with GNKLabSetsValuesInBulk.
+ */
+static void GNKLabTransferValuesInBulk(__strong id const *sourceValues, id receiver, GNKGenome *genome, GNKLabOptions options)
+{
+    const GNKGenomeEntry *entries = genome.entries;
+    NSUInteger count = genome.count;
+    
+    if (genome.receiverShape == GNKGenomeReceiverShapeKeys)
+    {
+        for (NSUInteger i = 0; i < count; i++)
+        {
+            GNKLabApplyDictionaryValue(sourceValues[i], receiver, &entries[i], options);
+        }
+        
+        return;
+    }
+    
+    __strong id *values = (__strong id *)calloc(count, sizeof(id));
+    NSUInteger *indexes = (NSUInteger *)malloc(count * sizeof(NSUInteger));
+    NSUInteger valueCount = 0;
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        id value = GNKTransformedTraitValue(sourceValues[i], entries[i].transformer, entries[i].reversesTransformer, options);
+        
+        if (!(options & GNKLabUseNilValues) && !value)
+        {
+            continue;
+        }
+        
+        if (!(options & GNKLabSkipPreSettingNilConversion) && value == [NSNull null])
+        {
+            value = nil;
+        }
+        
+        values[valueCount] = value;
+        indexes[valueCount] = i;
+        valueCount++;
+    }
+    
+    GNKLabSetArrayValues(values, indexes, valueCount, receiver, entries);
+    
+    for (NSUInteger i = 0; i < valueCount; i++)
+    {
+        values[i] = nil;
+    }
+    
+    free(values);
+    free(indexes);
+}
+
+/**
+ *  Retrieves the source value of every entry of the genome, using the values of the prefix nodes where possible, and sets them on a mutable dictionary or array receiver without key-value coding.
+ */
+static void GNKLabTransferGenomeInBulk(id source, id receiver, GNKGenome *genome, GNKLabOptions options)
+{
+    const GNKGenomeEntry *entries = genome.entries;
+    NSUInteger count = genome.count;
+    __strong id *nodeValues = GNKLabEvaluatePrefixNodes(source, genome);
+    
+    // Dictionary keys are set as each value is retrieved, so no buffer is needed.
+    if (genome.receiverShape == GNKGenomeReceiverShapeKeys)
+    {
+        for (NSUInteger i = 0; i < count; i++)
+        {
+            id value = (entries[i].prefixNode != NSNotFound) ? nodeValues[entries[i].prefixNode] : [entries[i].sourceTrait traitValueFromObject:source];
+            GNKLabApplyDictionaryValue(value, receiver, &entries[i], options);
+        }
+        
+        GNKLabReleasePrefixNodeValues(nodeValues, genome);
+        return;
+    }
+    
+    __strong id *sourceValues = (__strong id *)calloc(count, sizeof(id));
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        sourceValues[i] = (entries[i].prefixNode != NSNotFound) ? nodeValues[entries[i].prefixNode] : [entries[i].sourceTrait traitValueFromObject:source];
+    }
+    
+    GNKLabTransferValuesInBulk(sourceValues, receiver, genome, options);
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        sourceValues[i] = nil;
+    }
+    
+    free(sourceValues);
+    GNKLabReleasePrefixNodeValues(nodeValues, genome);
+}
+
+/**
+ *  Transfers every entry of the genome from the source to the receiver. If sequences in the genome share prefixes, the prefix nodes are evaluated once up front, and entries which end at a node use its value instead of evaluating their source traits again. If expensive entries are evaluated concurrently, they are evaluated after the prefix nodes, and their values are set in the genome's order along with every other entry.
+ *
+ *  Unless the transfer is instrumented, evaluates entries concurrently or skips unchanged values, all of which need to handle each entry themselves, the values are set all at once if the receiver is a collection the genome can build in bulk, or the genome's compiled program is run once the genome has been reused.
+ */
+static void GNKLabTransferGenome(id source, id receiver, GNKGenome *genome, GNKLabOptions options)
+{
+    NSUInteger concurrentCount = (options & GNKLabEvaluateExpensiveGenesConcurrently) ? genome.concurrentEntryCount : 0;
+    
+    if (__builtin_expect(!GNKGeneStatisticsEnabled, YES) && concurrentCount < 2 && !(options & GNKLabSkipUnchangedValues))
+    {
+        if (GNKLabSetsValuesInBulk(receiver, genome))
+        {
+            GNKLabTransferGenomeInBulk(source, receiver, genome, options);
+            return;
+        }
+        
+        GNKLabProgram *program = [genome programForOptions:options];
+        if (program)
+        {
+            GNKLabRunProgram(source, receiver, genome, program);
+            return;
+        }
+    }
+    
+    const GNKGenomeEntry *entries = genome.entries;
+    NSUInteger count = genome.count;
+    __strong id *nodeValues = GNKLabEvaluatePrefixNodes(source, genome);
+    
+    __strong id *concurrentValues = NULL;
+    NSUInteger concurrentIndex = 0;
+    
+    BOOL began = NO;
+    BOOL *changesBegan = GNKLabBatchesChanges(receiver, options) ? &began : NULL;
+    
+    if (concurrentCount >= 2)
+    {
+        concurrentValues = (__strong id *)calloc(concurrentCount, sizeof(id));
+        id exception = GNKLabEvaluateConcurrentEntries(source, nodeValues, genome, options, concurrentValues);
+        
+        if (exception)
+        {
+            for (NSUInteger i = 0; i < concurrentCount; i++)
+            {
+                concurrentValues[i] = nil;
+            }
+            
+            free(concurrentValues);
+            GNKLabReleasePrefixNodeValues(nodeValues, genome);
+            
+            @throw exception;
+        }
+    }
+    
+    // A raising setter must not leave the receiver inside a change batch, or leak the values which were not yet set.
+    @try
+    {
+        for (NSUInteger i = 0; i < count; i++)
+        {
+            if (concurrentValues && entries[i].evaluatesConcurrently)
+            {
+                if (options & GNKLabSkipUnchangedValues)
+                {
+                    GNKLabSetChangedValue(concurrentValues[concurrentIndex], receiver, &entries[i], options, changesBegan, 0, 0);
+                }
+                else if (__builtin_expect(GNKGeneStatisticsEnabled, NO))
+                {
+                    GNKLabSetValueInstrumented(concurrentValues[concurrentIndex], receiver, &entries[i], options, 0, 0);
+                }
+                else
+                {
+                    GNKLabSetValue(concurrentValues[concurrentIndex], receiver, &entries[i], options);
+                }
+                
+                concurrentValues[concurrentIndex++] = nil;
+            }
+            else if (entries[i].prefixNode != NSNotFound)
+            {
+                GNKLabTransferValue(nodeValues[entries[i].prefixNode], receiver, &entries[i], options, changesBegan);
+            }
+            else
+            {
+                GNKLabTransferEntry(source, receiver, &entries[i], options, changesBegan);
+            }
+        }
+    }
+    @finally
+    {
+        if (began)
+        {
+            [(id<GNKChangeBatchingReceiver>)receiver didChangeTraits];
+        }
+        
+        for (NSUInteger i = concurrentIndex; concurrentValues && i < concurrentCount; i++)
+        {
+            concurrentValues[i] = nil;
+        }
+        
+        GNKLabReleasePrefixNodeValues(nodeValues, genome);
+        free(concurrentValues);
+    }
+}
+
+/**
+ *  Transfers a value retrieved from a source object for every entry of the genome, in the genome's order. The values buffer must have one value per entry.
+ */
+static void GNKLabTransferValues(__strong id const *values, id receiver, GNKGenome *genome, GNKLabOptions options)
 {
-    id value = [trait traitValueFromObject:object];
+    const GNKGenomeEntry *entries = genome.entries;
+    NSUInteger count = genome.count;
     
-    if ((!(options & GNKLabUseNilValues) && !value) || !transformer)
+    if (__builtin_expect(!GNKGeneStatisticsEnabled, YES) && !(options & GNKLabSkipUnchangedValues) && GNKLabSetsValuesInBulk(receiver, genome))
     {
-        return value;
+        GNKLabTransferValuesInBulk(values, receiver, genome, options);
+        return;
     }
     
-    if (!(options & GNKLabSkipPreTranformationNilConversion) && value == [NSNull null])
+    BOOL began = NO;
+    BOOL *changesBegan = GNKLabBatchesChanges(receiver, options) ? &began : NULL;
+    
+    @try
     {
-        value = nil;
+        for (NSUInteger i = 0; i < count; i++)
+        {
+            GNKLabTransferValue(values[i], receiver, &entries[i], options, changesBegan);
+        }
+    }
+    @finally
+    {
+        if (began)
+        {
+            [(id<GNKChangeBatchingReceiver>)receiver didChangeTraits];
+        }
     }
+}
+
+/**
+ *  Compares a source value which has already been transformed with the receiver's trait value for a single entry.
+ */
+static BOOL GNKLabEntryHasDifferentValue(id sourceValue, id receiver, const GNKGenomeEntry *entry, GNKLabOptions options)
+{
+    id receivingValue = GNKTraitValue(receiver, entry->receivingTrait, nil, NO, options);
     
-    value = [transformer transformedValue:value];
+    return !GNKLabValuesAreEqual(sourceValue, receivingValue);
+}
+
+BOOL GNKLabEntryHasDifferentTraits(id source, id receiver, const GNKGenomeEntry *entry, GNKLabOptions options)
+{
+    return GNKLabEntryHasDifferentValue(GNKTraitValue(source, entry->sourceTrait, entry->transformer, entry->reversesTransformer, options), receiver, entry, options);
+}
+
+/**
+ *  Transfers a single entry whose transformer conforms to GNKBatchValueTransformer between many pairs of objects, transforming every value in a single call. The values buffer and indexes buffer must each have room for the number of pairs, and the values buffer is left empty afterwards.
+ */
+static void GNKLabTransferBatchEntry(__unsafe_unretained id const *sources, __unsafe_unretained id const *receivers, NSUInteger count, const GNKGenomeEntry *entry, GNKLabOptions options, __strong id *values, NSUInteger *indexes)
+{
+    BOOL instrumented = __builtin_expect(GNKGeneStatisticsEnabled, NO);
+    NSUInteger valueCount = 0;
+    NSUInteger nullCount = 0;
     
-    if (!(options & GNKLabSkipPostTranformationNullConversion) && !value)
+    // Values are gathered and converted exactly as GNKTraitValue would before transforming them.
+    for (NSUInteger i = 0; i < count; i++)
     {
-        value = [NSNull null];
+        id value = [entry->sourceTrait traitValueFromObject:sources[i]];
+        if (!(options & GNKLabUseNilValues) && !value)
+        {
+            continue;
+        }
+        
+        if (value == [NSNull null])
+        {
+            nullCount++;
+        }
+        
+        if (!(options & GNKLabSkipPreTranformationNilConversion) && value == [NSNull null])
+        {
+            value = nil;
+        }
+        
+        values[valueCount] = value;
+        indexes[valueCount] = i;
+        valueCount++;
     }
     
-    return value;
+    if (valueCount == 0)
+    {
+        if (instrumented)
+        {
+            GNKGeneStatisticsRecord(entry->gene, count, count, nullCount, 0, 0);
+        }
+        
+        return;
+    }
+    
+    uint64_t transformerStart = instrumented ? GNKGeneStatisticsTime() : 0;
+    [(id<GNKBatchValueTransformer>)entry->transformer transformValues:values count:valueCount];
+    uint64_t setterStart = instrumented ? GNKGeneStatisticsTime() : 0;
+    
+    NSUInteger setCount = 0;
+    
+    for (NSUInteger i = 0; i < valueCount; i++)
+    {
+        id value = values[i];
+        values[i] = nil;
+        
+        if (!(options & GNKLabSkipPostTranformationNullConversion) && !value)
+        {
+            value = [NSNull null];
+        }
+        
+        if (!(options & GNKLabUseNilValues) && !value)
+        {
+            continue;
+        }
+        
+        if (!(options & GNKLabSkipPreSettingNilConversion) && value == [NSNull null])
+        {
+            value = nil;
+        }
+        
+        [entry->receivingTrait setTraitValue:value onObject:receivers[indexes[i]]];
+        setCount++;
+    }
+    
+    if (instrumented)
+    {
+        GNKGeneStatisticsRecord(entry->gene, count, count - setCount, nullCount, setterStart - transformerStart, GNKGeneStatisticsTime() - setterStart);
+    }
+}
+
+/**
+ *  Transfers traits between each pair of objects in a chunk. If the lab class overrides +transferTraitsFromSource:receiver:compiledGenome:options:, that method is sent for each pair. Otherwise, if the genome has batch transformers, the chunk is walked one gene at a time so each batch transformer is called once for the entire chunk. Genes are still set on each receiver in the genome's order.
+ */
+static void GNKLabTransferChunk(Class labClass, __unsafe_unretained id const *sources, __unsafe_unretained id const *receivers, NSUInteger count, GNKGenome *genome, GNKLabOptions options)
+{
+    const GNKGenomeEntry *entries = genome.entries;
+    NSUInteger geneCount = genome.count;
+    
+    // Chunks are already transfered concurrently, so expensive genes are evaluated on the chunk's thread.
+    options &= ~GNKLabEvaluateExpensiveGenesConcurrently;
+    
+    SEL transferSelector = @selector(transferTraitsFromSource:receiver:compiledGenome:options:);
+    if ([labClass methodForSelector:transferSelector] != [GNKLab methodForSelector:transferSelector])
+    {
+        for (NSUInteger i = 0; i < count; i++)
+        {
+            [labClass transferTraitsFromSource:sources[i] receiver:receivers[i] compiledGenome:genome options:options];
+        }
+        
+        return;
+    }
+    
+    // Receivers which skip unchanged values may batch their changes, so each pair is transfered on its own.
+    if (!genome.hasBatchTransformers || (options & GNKLabSkipUnchangedValues))
+    {
+        for (NSUInteger i = 0; i < count; i++)
+        {
+            GNKLabTransferGenome(sources[i], receivers[i], genome, options);
+        }
+        
+        return;
+    }
+    
+    __strong id *values = (__strong id *)calloc(count, sizeof(id));
+    NSUInteger *indexes = (NSUInteger *)malloc(count * sizeof(NSUInteger));
+    
+    for (NSUInteger j = 0; j < geneCount; j++)
+    {
+        if (entries[j].transformsInBatches)
+        {
+            GNKLabTransferBatchEntry(sources, receivers, count, &entries[j], options, values, indexes);
+            continue;
+        }
+        
+        for (NSUInteger i = 0; i < count; i++)
+        {
+            GNKLabTransferEntry(sources[i], receivers[i], &entries[j], options, NULL);
+        }
+    }
+    
+    free(values);
+    free(indexes);
+}
+
+static NSUInteger GNKLabChunkSize(NSUInteger count, NSUInteger requestedChunkSize)
+{
+    if (requestedChunkSize > 0)
+    {
+        return requestedChunkSize;
+    }
+    
+    // Aim for several chunks per processor so that uneven chunks can be balanced by dispatch_apply.
+    NSUInteger chunkCount = [[NSProcessInfo processInfo] activeProcessorCount] * 8;
+    return MAX((count + chunkCount - 1) / chunkCount, (NSUInteger)1);
 }
 
 @implementation GNKLab
 
++ (void)setInstrumentationEnabled:(BOOL)instrumentationEnabled
+{
+    GNKGeneStatisticsEnabled = instrumentationEnabled;
+}
+
++ (BOOL)isInstrumentationEnabled
+{
+    return GNKGeneStatisticsEnabled;
+}
+
++ (NSArray *)geneStatistics
+{
+    return GNKGeneStatisticsCollect();
+}
+
++ (void)resetGeneStatistics
+{
+    GNKGeneStatisticsReset();
+}
+
 + (void)transferTraitsFromSource:(id)source receiver:(id)receiver genome:(NSArray *)genome options:(GNKLabOptions)options
 {
     NSParameterAssert(source);
     NSParameterAssert(receiver);
     NSParameterAssert(genome.count > 0);
     
-    NSOrderedSet *genomeCopy = [NSOrderedSet orderedSetWithArray:genome];
+    [self transferTraitsFromSource:source receiver:receiver compiledGenome:[GNKGenome genomeWithGenes:genome] options:options];
+}
+
++ (NSSet *)findGenesWithDifferentTraitsFromSource:(id)source receiver:(id)receiver genome:(NSArray *)genome options:(GNKLabOptions)options
+{
+    NSParameterAssert(source);
+    NSParameterAssert(receiver);
+    NSParameterAssert(genome.count > 0);
+    
+    return [self findGenesWithDifferentTraitsFromSource:source receiver:receiver compiledGenome:[GNKGenome genomeWithGenes:genome] options:options];
+}
+
++ (void)transferTraitsFromSource:(id)source receiver:(id)receiver compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options
+{
+    NSParameterAssert(source);
+    NSParameterAssert(receiver);
+    NSParameterAssert(genome);
+    
+    GNKLabTransferGenome(source, receiver, genome, options);
+}
+
++ (NSSet *)findGenesWithDifferentTraitsFromSource:(id)source receiver:(id)receiver compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options
+{
+    NSParameterAssert(source);
+    NSParameterAssert(receiver);
+    NSParameterAssert(genome);
+    
+    const GNKGenomeEntry *entries = genome.entries;
+    NSUInteger count = genome.count;
+    NSMutableSet *differentGenes = [NSMutableSet set];
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        if (GNKLabEntryHasDifferentTraits(source, receiver, &entries[i], options))
+        {
+            [differentGenes addObject:entries[i].gene];
+        }
+    }
+    
+    return [differentGenes copy];
+}
+
++ (BOOL)hasDifferentTraitsFromSource:(id)source receiver:(id)receiver compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options
+{
+    NSParameterAssert(source);
+    NSParameterAssert(receiver);
+    NSParameterAssert(genome);
+    
+    const GNKGenomeEntry *entries = genome.entries;
+    NSUInteger count = genome.count;
     
-    for (GNKGene *gene in genomeCopy)
+    for (NSUInteger i = 0; i < count; i++)
     {
-        id sourceValue = GNKTraitValue(source, gene.sourceTrait, gene.transformer, options);
-        if (!(options & GNKLabUseNilValues) && !sourceValue)
+        if (GNKLabEntryHasDifferentTraits(source, receiver, &entries[i], options))
+        {
+            return YES;
+        }
+    }
+    
+    return NO;
+}
+
++ (NSIndexSet *)indexesOfGenesWithDifferentTraitsFromSource:(id)source receiver:(id)receiver compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options
+{
+    NSParameterAssert(source);
+    NSParameterAssert(receiver);
+    NSParameterAssert(genome);
+    
+    const GNKGenomeEntry *entries = genome.entries;
+    NSUInteger count = genome.count;
+    NSMutableIndexSet *differentIndexes;
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        if (!GNKLabEntryHasDifferentTraits(source, receiver, &entries[i], options))
         {
             continue;
         }
         
-        if (!(options & GNKLabSkipPreSettingNilConversion) && sourceValue == [NSNull null])
+        // Most objects compared are unchanged, so the index set is only created once a difference is found.
+        if (!differentIndexes)
         {
-            sourceValue = nil;
+            differentIndexes = [NSMutableIndexSet indexSet];
         }
         
-        [gene.receivingTrait setTraitValue:sourceValue onObject:receiver];
+        [differentIndexes addIndex:i];
     }
+    
+    return differentIndexes ? [differentIndexes copy] : [NSIndexSet indexSet];
 }
 
-+ (NSSet *)findGenesWithDifferentTraitsFromSource:(id)source receiver:(id)receiver genome:(NSArray *)genome options:(GNKLabOptions)options
++ (GNKPatch *)patchWithDifferentTraitsFromSource:(id)source receiver:(id)receiver compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options
 {
     NSParameterAssert(source);
     NSParameterAssert(receiver);
-    NSParameterAssert(genome.count > 0);
+    NSParameterAssert(genome);
     
-    NSSet *genomeCopy = [NSSet setWithArray:genome];
-    NSMutableSet *differentGenes = [NSMutableSet set];
+    const GNKGenomeEntry *entries = genome.entries;
+    NSUInteger count = genome.count;
+    NSUInteger *indexes = NULL;
+    __strong id *values = NULL;
+    NSUInteger patchCount = 0;
     
-    for (GNKGene *gene in genomeCopy)
+    for (NSUInteger i = 0; i < count; i++)
     {
-        id sourceValue = GNKTraitValue(source, gene.sourceTrait, gene.transformer, options);
-        id receivingValue = GNKTraitValue(receiver, gene.receivingTrait, nil, options);
-        
-        if ((!sourceValue && !receivingValue) || (sourceValue && [receivingValue isEqual:sourceValue]))
+        id sourceValue = GNKTraitValue(source, entries[i].sourceTrait, entries[i].transformer, entries[i].reversesTransformer, options);
+        if (!GNKLabEntryHasDifferentValue(sourceValue, receiver, &entries[i], options))
         {
             continue;
         }
         
-        [differentGenes addObject:gene];
+        // Most objects compared are unchanged, so the buffers are only created once a difference is found.
+        if (!values)
+        {
+            indexes = (NSUInteger *)malloc(count * sizeof(NSUInteger));
+            values = (__strong id *)calloc(count, sizeof(id));
+        }
+        
+        indexes[patchCount] = i;
+        values[patchCount] = sourceValue;
+        patchCount++;
     }
     
-    return [differentGenes copy];
+    if (patchCount > 0 && patchCount < count)
+    {
+        // Only the retained pointers are moved, so the values do not need to be retained again.
+        indexes = (NSUInteger *)realloc(indexes, patchCount * sizeof(NSUInteger));
+        values = (__strong id *)realloc(values, patchCount * sizeof(id));
+    }
+    
+    return [[GNKPatch alloc] initWithGenome:genome options:options indexes:indexes values:values count:patchCount];
+}
+
++ (void)applyPatch:(GNKPatch *)patch toReceiver:(id)receiver
+{
+    NSParameterAssert(patch);
+    NSParameterAssert(receiver);
+    
+    const GNKGenomeEntry *entries = patch.genome.entries;
+    const NSUInteger *indexes = patch.indexes;
+    __unsafe_unretained id const *values = patch.values;
+    NSUInteger count = patch.count;
+    GNKLabOptions options = patch.options;
+    
+    BOOL began = NO;
+    BOOL *changesBegan = GNKLabBatchesChanges(receiver, options) ? &began : NULL;
+    
+    @try
+    {
+        for (NSUInteger i = 0; i < count; i++)
+        {
+            // The values were transformed when the patch was created, so only the setter is instrumented.
+            if (options & GNKLabSkipUnchangedValues)
+            {
+                GNKLabSetChangedValue(values[i], receiver, &entries[indexes[i]], options, changesBegan, 0, 0);
+            }
+            else if (__builtin_expect(GNKGeneStatisticsEnabled, NO))
+            {
+                GNKLabSetValueInstrumented(values[i], receiver, &entries[indexes[i]], options, 0, 0);
+            }
+            else
+            {
+                GNKLabSetValue(values[i], receiver, &entries[indexes[i]], options);
+            }
+        }
+    }
+    @finally
+    {
+        if (began)
+        {
+            [(id<GNKChangeBatchingReceiver>)receiver didChangeTraits];
+        }
+    }
+}
+
++ (void)transferTraitsFromSources:(NSArray *)sources receivers:(NSArray *)receivers compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options chunkSize:(NSUInteger)chunkSize
+{
+    NSParameterAssert(sources);
+    NSParameterAssert(receivers.count == sources.count);
+    NSParameterAssert(genome);
+    
+    NSArray *sourcesCopy = [sources copy];
+    NSArray *receiversCopy = [receivers copy];
+    NSUInteger count = sourcesCopy.count;
+    
+    if (count == 0)
+    {
+        return;
+    }
+    
+    chunkSize = GNKLabChunkSize(count, chunkSize);
+    size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    
+    // An exception escaping a dispatch_apply block terminates the process, so the first one is raised on the calling thread instead.
+    __block void *firstException = NULL;
+    
+    dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+        @autoreleasepool
+        {
+            NSRange range = NSMakeRange(chunk * chunkSize, MIN(chunkSize, count - chunk * chunkSize));
+            
+            // The copied arrays retain the objects, so the chunk can be walked without retaining them again.
+            __unsafe_unretained id *objects = (__unsafe_unretained id *)malloc(range.length * 2 * sizeof(id));
+            [sourcesCopy getObjects:objects range:range];
+            [receiversCopy getObjects:(objects + range.length) range:range];
+            
+            @try
+            {
+                GNKLabTransferChunk(self, objects, objects + range.length, range.length, genome, options);
+            }
+            @catch (id exception)
+            {
+                GNKLabRecordException(&firstException, exception);
+            }
+            
+            free(objects);
+        }
+    });
+    
+    id exception = GNKLabTakeException(&firstException);
+    if (exception)
+    {
+        @throw exception;
+    }
+}
+
++ (NSArray *)receiversByTransferringTraitsFromSources:(NSArray *)sources compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options chunkSize:(NSUInteger)chunkSize receiverFactory:(id (^)(id))receiverFactory
+{
+    NSParameterAssert(sources);
+    NSParameterAssert(genome);
+    NSParameterAssert(receiverFactory);
+    
+    NSArray *sourcesCopy = [sources copy];
+    NSUInteger count = sourcesCopy.count;
+    
+    if (count == 0)
+    {
+        return @[];
+    }
+    
+    chunkSize = GNKLabChunkSize(count, chunkSize);
+    size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    
+    // Each chunk writes to its own range of the buffer, so no synchronization is necessary.
+    __strong id *receivers = (__strong id *)calloc(count, sizeof(id));
+    __block void *firstException = NULL;
+    
+    dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+        @autoreleasepool
+        {
+            NSRange range = NSMakeRange(chunk * chunkSize, MIN(chunkSize, count - chunk * chunkSize));
+            
+            __unsafe_unretained id *sourceObjects = (__unsafe_unretained id *)malloc(range.length * sizeof(id));
+            [sourcesCopy getObjects:sourceObjects range:range];
+            
+            @try
+            {
+                for (NSUInteger i = 0; i < range.length; i++)
+                {
+                    id receiver = receiverFactory(sourceObjects[i]);
+                    if (!receiver)
+                    {
+                        [NSException raise:NSInvalidArgumentException format:@"The receiver factory must not return nil."];
+                    }
+                    
+                    receivers[range.location + i] = receiver;
+                }
+                
+                GNKLabTransferChunk(self, sourceObjects, receivers + range.location, range.length, genome, options);
+            }
+            @catch (id exception)
+            {
+                GNKLabRecordException(&firstException, exception);
+            }
+            
+            free(sourceObjects);
+        }
+    });
+    
+    id exception = GNKLabTakeException(&firstException);
+    NSArray *result = exception ? nil : [NSArray arrayWithObjects:receivers count:count];
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        receivers[i] = nil;
+    }
+    free(receivers);
+    
+    if (exception)
+    {
+        @throw exception;
+    }
+    
+    return result;
+}
+
++ (BOOL)transferTraitsFromJSONData:(NSData *)data receiver:(id)receiver compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options error:(NSError **)error
+{
+    NSParameterAssert(data);
+    NSParameterAssert(receiver);
+    NSParameterAssert(genome);
+    
+    GNKJSONMatcher *matcher = genome.JSONMatcher;
+    if (!matcher)
+    {
+        id source = [NSJSONSerialization JSONObjectWithData:data options:0 error:error];
+        if (!source)
+        {
+            return NO;
+        }
+        
+        [self transferTraitsFromSource:source receiver:receiver compiledGenome:genome options:options];
+        return YES;
+    }
+    
+    NSUInteger count = genome.count;
+    __strong id *values = (__strong id *)calloc(count, sizeof(id));
+    
+    BOOL matched = [matcher matchValuesInData:data values:values error:error];
+    
+    if (matched)
+    {
+        GNKLabTransferValues(values, receiver, genome, options);
+    }
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        values[i] = nil;
+    }
+    
+    free(values);
+    
+    return matched;
+}
+
++ (NSArray *)receiversByTransferringTraitsFromJSONData:(NSData *)data compiledGenome:(GNKGenome *)genome options:(GNKLabOptions)options receiverFactory:(id (^)(NSUInteger))receiverFactory error:(NSError **)error
+{
+    NSParameterAssert(data);
+    NSParameterAssert(genome);
+    NSParameterAssert(receiverFactory);
+    
+    NSMutableArray *receivers = [NSMutableArray array];
+    GNKJSONMatcher *matcher = genome.JSONMatcher;
+    
+    if (!matcher)
+    {
+        id sources = [NSJSONSerialization JSONObjectWithData:data options:0 error:error];
+        if (!sources)
+        {
+            return nil;
+        }
+        else if (![sources isKindOfClass:[NSArray class]])
+        {
+            if (error)
+            {
+                *error = [NSError errorWithDomain:GNKLabErrorDomain code:GNKLabErrorInvalidJSON userInfo:@{NSLocalizedDescriptionKey: @"The top level JSON value is not an array."}];
+            }
+            
+            return nil;
+        }
+        
+        [sources enumerateObjectsUsingBlock:^(id source, NSUInteger idx, BOOL *stop) {
+            id receiver = receiverFactory(idx);
+            NSCAssert(receiver, @"The receiver factory must not return nil.");
+            
+            [self transferTraitsFromSource:source receiver:receiver compiledGenome:genome options:options];
+            [receivers addObject:receiver];
+        }];
+        
+        return [receivers copy];
+    }
+    
+    __strong id *values = (__strong id *)calloc(genome.count, sizeof(id));
+    
+    BOOL matched = [matcher matchValuesOfElementsInData:data values:values usingBlock:^(NSUInteger index) {
+        id receiver = receiverFactory(index);
+        NSCAssert(receiver, @"The receiver factory must not return nil.");
+        
+        GNKLabTransferValues(values, receiver, genome, options);
+        [receivers addObject:receiver];
+    } error:error];
+    
+    free(values);
+    
+    return matched ? [receivers copy] : nil;
 }
 
 - (instancetype)init
@@ -0,0 +1,210 @@
+//
+//  GNKLabProgram.m
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/28/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import "GNKLabProgram_Private.h"
+#import "GNKGenome_Private.h"
+#import "GNKTrait_Private.h"
+#import <objc/runtime.h>
+
+typedef id (*GNKLabGetterFunction)(id, SEL, id);
+typedef void (*GNKLabSetterFunction)(id, SEL, id, id);
+
+/**
+ *  Sets a value which has already been transformed, exactly as GNKLab would after transforming it. Every step passes constant options, so each step only contains the checks its options require.
+ */
+static inline __attribute((always_inline)) void GNKLabProgramSetValue(id value, id receiver, id receivingTrait, GNKLabSetterFunction setter, __unsafe_unretained id null, const BOOL useNilValues, const BOOL skipPreSettingNilConversion)
+{
+    if (!useNilValues && !value)
+    {
+        return;
+    }
+    
+    if (!skipPreSettingNilConversion && value == null)
+    {
+        value = nil;
+    }
+    
+    setter(receivingTrait, @selector(setTraitValue:onObject:), value, receiver);
+}
+
+/**
+ *  Compiles the part of an entry which transforms a value and sets it on the receiver.
+ */
+static GNKLabStep GNKLabProgramValueStep(const GNKGenomeEntry *entry, GNKLabOptions options)
+{
+    id receivingTrait = entry->receivingTrait;
+    GNKLabSetterFunction setter = (GNKLabSetterFunction)class_getMethodImplementation(object_getClass(receivingTrait), @selector(setTraitValue:onObject:));
+    __unsafe_unretained id null = [NSNull null];
+    
+    BOOL useNilValues = (options & GNKLabUseNilValues) != 0;
+    BOOL skipPreTransformationNilConversion = (options & GNKLabSkipPreTranformationNilConversion) != 0;
+    BOOL skipPostTransformationNullConversion = (options & GNKLabSkipPostTranformationNullConversion) != 0;
+    BOOL skipPreSettingNilConversion = (options & GNKLabSkipPreSettingNilConversion) != 0;
+    
+    if (!entry->transformer)
+    {
+        if (!useNilValues && !skipPreSettingNilConversion)
+        {
+            return ^(id value, id receiver) {
+                GNKLabProgramSetValue(value, receiver, receivingTrait, setter, null, NO, NO);
+            };
+        }
+        else if (!useNilValues)
+        {
+            return ^(id value, id receiver) {
+                GNKLabProgramSetValue(value, receiver, receivingTrait, setter, null, NO, YES);
+            };
+        }
+        else if (!skipPreSettingNilConversion)
+        {
+            return ^(id value, id receiver) {
+                GNKLabProgramSetValue(value, receiver, receivingTrait, setter, null, YES, NO);
+            };
+        }
+        
+        return ^(id value, id receiver) {
+            GNKLabProgramSetValue(value, receiver, receivingTrait, setter, null, YES, YES);
+        };
+    }
+    
+    NSValueTransformer *transformer = entry->transformer;
+    SEL transformSelector = entry->reversesTransformer ? @selector(reverseTransformedValue:) : @selector(transformedValue:);
+    GNKLabGetterFunction transform = (GNKLabGetterFunction)class_getMethodImplementation(object_getClass(transformer), transformSelector);
+    
+    if ((options & GNKLabProgramOptionsMask) == 0)
+    {
+        // With the default options, NSNull is transformed as nil, and both nil and NSNull results are set as nil.
+        return ^(id value, id receiver) {
+            if (!value)
+            {
+                return;
+            }
+            
+            value = transform(transformer, transformSelector, (value == null) ? nil : value);
+            setter(receivingTrait, @selector(setTraitValue:onObject:), (value == null) ? nil : value, receiver);
+        };
+    }
+    
+    return ^(id value, id receiver) {
+        if (!useNilValues && !value)
+        {
+            return;
+        }
+        
+        if (!skipPreTransformationNilConversion && value == null)
+        {
+            value = nil;
+        }
+        
+        value = transform(transformer, transformSelector, value);
+        
+        if (!skipPostTransformationNullConversion && !value)
+        {
+            value = null;
+        }
+        
+        GNKLabProgramSetValue(value, receiver, receivingTrait, setter, null, useNilValues, skipPreSettingNilConversion);
+    };
+}
+
+/**
+ *  Compiles an entry which retrieves its value from the source object. Entries without a transformer under the default options are compiled into a single step, since they are by far the most common.
+ */
+static GNKLabStep GNKLabProgramSourceStep(const GNKGenomeEntry *entry, GNKLabStep valueStep, GNKLabOptions options)
+{
+    id sourceTrait = entry->sourceTrait;
+    GNKLabGetterFunction getter = (GNKLabGetterFunction)class_getMethodImplementation(object_getClass(sourceTrait), @selector(traitValueFromObject:));
+    
+    if (entry->copiesScalarValues)
+    {
+        id receivingTrait = entry->receivingTrait;
+        
+        // Scalar values are never nil or NSNull, so none of the options apply to them.
+        return ^(id source, id receiver) {
+            if (GNKTraitCopyScalarValue(sourceTrait, source, receivingTrait, receiver))
+            {
+                return;
+            }
+            
+            valueStep(getter(sourceTrait, @selector(traitValueFromObject:), source), receiver);
+        };
+    }
+    
+    if (!entry->transformer && (options & GNKLabProgramOptionsMask) == 0)
+    {
+        id receivingTrait = entry->receivingTrait;
+        GNKLabSetterFunction setter = (GNKLabSetterFunction)class_getMethodImplementation(object_getClass(receivingTrait), @selector(setTraitValue:onObject:));
+        __unsafe_unretained id null = [NSNull null];
+        
+        return ^(id source, id receiver) {
+            GNKLabProgramSetValue(getter(sourceTrait, @selector(traitValueFromObject:), source), receiver, receivingTrait, setter, null, NO, NO);
+        };
+    }
+    
+    return ^(id source, id receiver) {
+        valueStep(getter(sourceTrait, @selector(traitValueFromObject:), source), receiver);
+    };
+}
+
+@implementation GNKLabProgram
+{
+    NSArray *_retainedSteps;
+}
+
++ (instancetype)programWithGenome:(GNKGenome *)genome options:(GNKLabOptions)options
+{
+    return [[self alloc] initWithGenome:genome options:options];
+}
+
+- (instancetype)initWithGenome:(GNKGenome *)genome options:(GNKLabOptions)options
+{
+    NSParameterAssert(genome);
+    
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    const GNKGenomeEntry *entries = genome.entries;
+    NSUInteger count = genome.count;
+    
+    NSMutableArray *retainedSteps = [NSMutableArray arrayWithCapacity:count];
+    __unsafe_unretained GNKLabStep *steps = (__unsafe_unretained GNKLabStep *)calloc(count, sizeof(GNKLabStep));
+    
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        GNKLabStep step = GNKLabProgramValueStep(&entries[i], options);
+        
+        // Entries with a prefix node are handed the node's value, so they only need the value step.
+        if (entries[i].prefixNode == NSNotFound)
+        {
+            step = GNKLabProgramSourceStep(&entries[i], step, options);
+        }
+        
+        [retainedSteps addObject:step];
+        steps[i] = step;
+    }
+    
+    _retainedSteps = [retainedSteps copy];
+    _steps = steps;
+    
+    return self;
+}
+
+- (instancetype)init
+{
+    [self doesNotRecognizeSelector:_cmd];
+    return nil;
+}
+
+- (void)dealloc
+{
+    free((void *)_steps);
+}
+
+@end
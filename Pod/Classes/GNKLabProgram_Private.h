@@ -0,0 +1,48 @@
+//
+//  GNKLabProgram_Private.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/28/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import "GNKLab.h"
+
+@class GNKGenome;
+
+/**
+ *  A single compiled gene. The first argument is the source object, or the value of the gene's prefix node if it has one.
+ */
+typedef void (^GNKLabStep)(id object, id receiver);
+
+/**
+ *  The options which change how values are transfered, and so which steps are compiled. Every other option is ignored by programs.
+ */
+enum
+{
+    GNKLabProgramOptionsMask = GNKLabUseNilValues | GNKLabSkipPreTranformationNilConversion | GNKLabSkipPostTranformationNullConversion | GNKLabSkipPreSettingNilConversion
+};
+
+/**
+ *  A GNKLabProgram is a genome compiled for a single options mask. Each gene becomes a step which calls the implementations of its traits and transformer directly, and which only performs the conversions its options require, so transfering traits is a straight walk over the steps.
+ *
+ *  Steps transfer values exactly as GNKLabTransferEntry would, except that steps for genes with a prefix node expect the node's value rather than the source object.
+ */
+@interface GNKLabProgram : NSObject
+
+/**
+ *  Compiles a program for the genome.
+ *
+ *  @param genome  The genome to compile.
+ *  @param options The options to compile the steps for. Only the options in GNKLabProgramOptionsMask are used.
+ *
+ *  @return A new program.
+ */
++ (instancetype)programWithGenome:(GNKGenome *)genome options:(GNKLabOptions)options __attribute((nonnull));
+
+/**
+ *  A contiguous array of steps, one for each gene in the genome and in the same order. The array is valid for the lifetime of the receiver.
+ */
+@property (assign, nonatomic, readonly) __unsafe_unretained GNKLabStep const *steps;
+
+@end
@@ -0,0 +1,43 @@
+//
+//  GNKLab_Private.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/26/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import "GNKLab.h"
+#import "GNKGenome_Private.h"
+
+/**
+ *  Transfers the trait value of a single genome entry from the source to the receiver, exactly as +[GNKLab transferTraitsFromSource:receiver:compiledGenome:options:] does for each of its genes.
+ *
+ *  @param source       The source object which will provide the trait value.
+ *  @param receiver     The receiving object which will have the value set on it.
+ *  @param entry        The genome entry to transfer.
+ *  @param options      A bitmask of options to use when transfering the trait.
+ *  @param changesBegan If GNKLabBatchesChanges returned YES for the receiver, a flag which is set once the receiver has been told its changes will begin, and which should start as NO for each transfer. Otherwise NULL.
+ */
+FOUNDATION_EXTERN void GNKLabTransferEntry(id source, id receiver, const GNKGenomeEntry *entry, GNKLabOptions options, BOOL *changesBegan);
+
+/**
+ *  Checks if the receiver should be told when changes to its traits begin and end during a transfer with the options. If so, the caller must call -[GNKChangeBatchingReceiver didChangeTraits] once every entry has been transfered if the changesBegan flag was set.
+ *
+ *  @param receiver The receiving object which will have values set on it.
+ *  @param options  A bitmask of options to use when transfering traits.
+ *
+ *  @return YES if GNKLabSkipUnchangedValues was passed and the receiver conforms to GNKChangeBatchingReceiver, NO otherwise.
+ */
+FOUNDATION_EXTERN BOOL GNKLabBatchesChanges(id receiver, GNKLabOptions options);
+
+/**
+ *  Compares the trait values of a single genome entry between the source and receiver, exactly as +[GNKLab findGenesWithDifferentTraitsFromSource:receiver:compiledGenome:options:] does for each of its genes.
+ *
+ *  @param source   The source object which will provide the trait value to compare with.
+ *  @param receiver The receiving object which will have its trait value compared against.
+ *  @param entry    The genome entry to compare.
+ *  @param options  A bitmask of options to use when retrieving traits.
+ *
+ *  @return YES if the trait values are not equivalent, NO if they are.
+ */
+FOUNDATION_EXTERN BOOL GNKLabEntryHasDifferentTraits(id source, id receiver, const GNKGenomeEntry *entry, GNKLabOptions options);
@@ -0,0 +1,72 @@
+//
+//  GNKMemoizingTransformer.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/26/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  A GNKMemoizingTransformer wraps another NSValueTransformer and remembers the values it returned for the most recently used inputs, so transforming a repeated input skips the wrapped transformer entirely.
+ *
+ *  This is useful for expensive transformers, like date parsers, which see the same inputs across many transfers. The cache is bounded and evicts the least recently used input once it is full. Inputs are compared with -isEqual:, so the wrapped transformer must always return equivalent values for equivalent inputs. Inputs which conform to NSCopying are copied before they are transformed and remembered, so mutating an input afterwards does not affect the cache.
+ *
+ *  A memoizing transformer is safe to use from many threads at once. The wrapped transformer may be called concurrently for different inputs, and is not called while the cache is locked.
+ *
+ *  ```
+ *  NSValueTransformer *transformer = [GNKMemoizingTransformer transformerWithValueTransformer:dateTransformer capacity:256];
+ *  GNKGene *gene = GNKMakeGene(@"created_at", @"createdAt", transformer);
+ *  ```
+ */
+@interface GNKMemoizingTransformer : NSValueTransformer
+
+/**
+ *  Convenience method which creates a memoizing transformer.
+ *
+ *  @see initWithValueTransformer:capacity:
+ *
+ *  @param transformer The transformer whose values should be remembered. This must not be nil.
+ *  @param capacity    The maximum number of inputs to remember. This must be greater than 0.
+ *
+ *  @return A new memoizing transformer.
+ */
++ (instancetype)transformerWithValueTransformer:(NSValueTransformer *)transformer capacity:(NSUInteger)capacity __attribute((nonnull));
+
+/**
+ *  Initializes the receiver with a transformer to wrap. This is the designated initializer.
+ *
+ *  @param transformer The transformer whose values should be remembered. This must not be nil.
+ *  @param capacity    The maximum number of inputs to remember. This must be greater than 0.
+ *
+ *  @return An initialized instance of the receiver.
+ */
+- (instancetype)initWithValueTransformer:(NSValueTransformer *)transformer capacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER __attribute((nonnull));
+
+/**
+ *  The wrapped transformer.
+ */
+@property (strong, nonatomic, readonly) NSValueTransformer *transformer;
+
+/**
+ *  The maximum number of inputs the receiver remembers.
+ */
+@property (assign, nonatomic, readonly) NSUInteger capacity;
+
+/**
+ *  The number of transformations which were answered from the cache.
+ */
+@property (assign, nonatomic, readonly) NSUInteger hitCount;
+
+/**
+ *  The number of transformations which had to call the wrapped transformer.
+ */
+@property (assign, nonatomic, readonly) NSUInteger missCount;
+
+/**
+ *  Forgets every remembered value and resets the hit and miss counts.
+ */
+- (void)removeAllCachedValues;
+
+@end
@@ -0,0 +1,257 @@
+//
+//  GNKMemoizingTransformer.m
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/26/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import "GNKMemoizingTransformer.h"
+#import <pthread.h>
+
+/**
+ *  A single remembered transformation, linked into the receiver's recency list.
+ */
+@interface _GNKMemoizedValue : NSObject
+{
+    @package
+    id _input;
+    id _value;
+    __unsafe_unretained _GNKMemoizedValue *_previous;
+    _GNKMemoizedValue *_next;
+}
+
+@end
+
+@implementation _GNKMemoizedValue
+@end
+
+@implementation GNKMemoizingTransformer
+{
+    pthread_mutex_t _lock;
+    
+    NSMapTable *_memoizedValuesForInputs;
+    
+    // The most recently used value is first, and the least recently used is last.
+    _GNKMemoizedValue *_first;
+    __unsafe_unretained _GNKMemoizedValue *_last;
+    
+    NSUInteger _hitCount;
+    NSUInteger _missCount;
+}
+
+#pragma mark - API
+
++ (instancetype)transformerWithValueTransformer:(NSValueTransformer *)transformer capacity:(NSUInteger)capacity
+{
+    return [[self alloc] initWithValueTransformer:transformer capacity:capacity];
+}
+
+- (instancetype)initWithValueTransformer:(NSValueTransformer *)transformer capacity:(NSUInteger)capacity
+{
+    NSParameterAssert(transformer);
+    NSParameterAssert(capacity > 0);
+    
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    pthread_mutex_init(&_lock, NULL);
+    
+    _transformer = transformer;
+    _capacity = capacity;
+    _memoizedValuesForInputs = [NSMapTable strongToStrongObjectsMapTable];
+    
+    return self;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init
+{
+    [self doesNotRecognizeSelector:_cmd];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (void)dealloc
+{
+    [self unlinkAllMemoizedValues];
+    pthread_mutex_destroy(&_lock);
+}
+
+- (NSUInteger)hitCount
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger hitCount = _hitCount;
+    pthread_mutex_unlock(&_lock);
+    
+    return hitCount;
+}
+
+- (NSUInteger)missCount
+{
+    pthread_mutex_lock(&_lock);
+    NSUInteger missCount = _missCount;
+    pthread_mutex_unlock(&_lock);
+    
+    return missCount;
+}
+
+- (void)removeAllCachedValues
+{
+    pthread_mutex_lock(&_lock);
+    
+    [self unlinkAllMemoizedValues];
+    [_memoizedValuesForInputs removeAllObjects];
+    _hitCount = 0;
+    _missCount = 0;
+    
+    pthread_mutex_unlock(&_lock);
+}
+
+
+#pragma mark - Internal
+
+/**
+ *  Unlinks the memoized value from the recency list. This must be called while locked.
+ */
+- (void)unlinkMemoizedValue:(_GNKMemoizedValue *)memoizedValue
+{
+    if (memoizedValue->_previous)
+    {
+        memoizedValue->_previous->_next = memoizedValue->_next;
+    }
+    else
+    {
+        _first = memoizedValue->_next;
+    }
+    
+    if (memoizedValue->_next)
+    {
+        memoizedValue->_next->_previous = memoizedValue->_previous;
+    }
+    else
+    {
+        _last = memoizedValue->_previous;
+    }
+    
+    memoizedValue->_previous = nil;
+    memoizedValue->_next = nil;
+}
+
+/**
+ *  Empties the recency list one value at a time. Releasing the first value of a long list would otherwise release the rest recursively, which can overflow the stack. This must be called while locked.
+ */
+- (void)unlinkAllMemoizedValues
+{
+    _GNKMemoizedValue *memoizedValue = _first;
+    _first = nil;
+    _last = nil;
+    
+    while (memoizedValue)
+    {
+        _GNKMemoizedValue *next = memoizedValue->_next;
+        memoizedValue->_next = nil;
+        memoizedValue->_previous = nil;
+        memoizedValue = next;
+    }
+}
+
+/**
+ *  Links the memoized value at the start of the recency list. This must be called while locked.
+ */
+- (void)linkFirstMemoizedValue:(_GNKMemoizedValue *)memoizedValue
+{
+    memoizedValue->_next = _first;
+    
+    if (_first)
+    {
+        _first->_previous = memoizedValue;
+    }
+    else
+    {
+        _last = memoizedValue;
+    }
+    
+    _first = memoizedValue;
+}
+
+
+#pragma mark - NSValueTransformer
+
++ (BOOL)allowsReverseTransformation
+{
+    // Reverse transformations are not remembered, and whether they are possible depends on the wrapped transformer.
+    return NO;
+}
+
+- (id)transformedValue:(id)value
+{
+    // NSMapTable does not accept nil keys, so nil inputs are remembered with a placeholder which cannot be confused with NSNull.
+    static id nilInput;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        nilInput = [NSObject new];
+    });
+    
+    id input = value ?: nilInput;
+    
+    pthread_mutex_lock(&_lock);
+    
+    _GNKMemoizedValue *memoizedValue = [_memoizedValuesForInputs objectForKey:input];
+    if (memoizedValue)
+    {
+        _hitCount++;
+        
+        if (memoizedValue != _first)
+        {
+            [self unlinkMemoizedValue:memoizedValue];
+            [self linkFirstMemoizedValue:memoizedValue];
+        }
+        
+        id transformedValue = memoizedValue->_value;
+        pthread_mutex_unlock(&_lock);
+        
+        return transformedValue;
+    }
+    
+    _missCount++;
+    pthread_mutex_unlock(&_lock);
+    
+    // Mutable inputs are copied before they are transformed, so the remembered input is exactly the one which was transformed and later changes to the original cannot corrupt the cache.
+    if ([value conformsToProtocol:@protocol(NSCopying)])
+    {
+        value = [value copy];
+        input = value;
+    }
+    
+    id transformedValue = [self.transformer transformedValue:value];
+    
+    pthread_mutex_lock(&_lock);
+    
+    // Another thread may have remembered the same input in the meantime, in which case the first one wins.
+    if (![_memoizedValuesForInputs objectForKey:input])
+    {
+        memoizedValue = [_GNKMemoizedValue new];
+        memoizedValue->_input = input;
+        memoizedValue->_value = transformedValue;
+        
+        [_memoizedValuesForInputs setObject:memoizedValue forKey:input];
+        [self linkFirstMemoizedValue:memoizedValue];
+        
+        if (_memoizedValuesForInputs.count > self.capacity)
+        {
+            _GNKMemoizedValue *evictedValue = _last;
+            [self unlinkMemoizedValue:evictedValue];
+            [_memoizedValuesForInputs removeObjectForKey:evictedValue->_input];
+        }
+    }
+    
+    pthread_mutex_unlock(&_lock);
+    
+    return transformedValue;
+}
+
+@end
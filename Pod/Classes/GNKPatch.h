@@ -0,0 +1,59 @@
+//
+//  GNKPatch.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/28/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "GNKLab.h"
+
+@class GNKGene, GNKGenome;
+
+/**
+ *  A GNKPatch is an immutable record of the genes whose traits differed between a source and a receiver, along with the source values of those genes. Values are stored after the genes' transformers have been applied, so a patch can be applied to any number of receivers, on any thread, without reading the source or running a transformer again.
+ *
+ *  Patches are created by +[GNKLab patchWithDifferentTraitsFromSource:receiver:compiledGenome:options:] and applied with +[GNKLab applyPatch:toReceiver:].
+ */
+@interface GNKPatch : NSObject
+
+/**
+ *  The genome the patch was created with.
+ */
+@property (strong, nonatomic, readonly) GNKGenome *genome;
+
+/**
+ *  The options the patch was created with, which are also used when it is applied.
+ */
+@property (assign, nonatomic, readonly) GNKLabOptions options;
+
+/**
+ *  The number of genes in the patch. This is 0 if the source and receiver did not differ.
+ */
+@property (assign, nonatomic, readonly) NSUInteger count;
+
+/**
+ *  The positions in the genome of the genes in the patch.
+ */
+@property (copy, nonatomic, readonly) NSIndexSet *geneIndexes;
+
+/**
+ *  Returns a gene in the patch. Genes are in the same order as in the genome.
+ *
+ *  @param index The position of the gene in the patch. This must be less than the count.
+ *
+ *  @return The gene at the position.
+ */
+- (GNKGene *)geneAtIndex:(NSUInteger)index;
+
+/**
+ *  Returns the transformed source value of a gene in the patch. This is the value which is set on receivers, before `[NSNull null]` is converted into `nil`.
+ *
+ *  @param index The position of the gene in the patch. This must be less than the count.
+ *
+ *  @return The value of the gene at the position, which may be `nil` or `[NSNull null]`.
+ */
+- (id)valueAtIndex:(NSUInteger)index;
+
+@end
@@ -0,0 +1,104 @@
+//
+//  GNKPatch.m
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/28/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import "GNKPatch_Private.h"
+#import "GNKGenome.h"
+
+@implementation GNKPatch
+{
+    __strong id *_values;
+}
+
+#pragma mark - API
+
+- (instancetype)initWithGenome:(GNKGenome *)genome options:(GNKLabOptions)options indexes:(NSUInteger *)indexes values:(__strong id *)values count:(NSUInteger)count
+{
+    NSParameterAssert(genome);
+    NSParameterAssert(count == 0 || (indexes && values));
+    
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    _genome = genome;
+    _options = options;
+    _indexes = indexes;
+    _values = values;
+    _count = count;
+    
+    return self;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init
+{
+    [self doesNotRecognizeSelector:_cmd];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (void)dealloc
+{
+    for (NSUInteger i = 0; i < _count; i++)
+    {
+        _values[i] = nil;
+    }
+    
+    free(_values);
+    free((void *)_indexes);
+}
+
+- (__unsafe_unretained id const *)values
+{
+    return (__unsafe_unretained id const *)_values;
+}
+
+- (NSIndexSet *)geneIndexes
+{
+    NSMutableIndexSet *geneIndexes = [NSMutableIndexSet indexSet];
+    
+    for (NSUInteger i = 0; i < _count; i++)
+    {
+        [geneIndexes addIndex:_indexes[i]];
+    }
+    
+    return [geneIndexes copy];
+}
+
+- (GNKGene *)geneAtIndex:(NSUInteger)index
+{
+    NSParameterAssert(index < _count);
+    
+    return [self.genome geneAtIndex:_indexes[index]];
+}
+
+- (id)valueAtIndex:(NSUInteger)index
+{
+    NSParameterAssert(index < _count);
+    
+    return _values[index];
+}
+
+
+#pragma mark - NSObject
+
+- (NSString *)description
+{
+    NSMutableArray *changes = [NSMutableArray arrayWithCapacity:_count];
+    
+    for (NSUInteger i = 0; i < _count; i++)
+    {
+        [changes addObject:[NSString stringWithFormat:@"%@ = %@", [self geneAtIndex:i], _values[i]]];
+    }
+    
+    return [NSString stringWithFormat:@"<%@: %p> (%@)", NSStringFromClass([self class]), self, [changes componentsJoinedByString:@", "]];
+}
+
+@end
@@ -0,0 +1,36 @@
+//
+//  GNKPatch_Private.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/28/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import "GNKPatch.h"
+
+@interface GNKPatch ()
+
+/**
+ *  Initializes the receiver with buffers of gene positions and values, taking ownership of both. The buffers must have room for at least `count` elements and must have been allocated with malloc or calloc. This is the designated initializer.
+ *
+ *  @param genome  The genome the positions refer to.
+ *  @param options The options the values were retrieved with.
+ *  @param indexes The positions in the genome of the genes in the patch, in ascending order. This may be NULL if the count is 0.
+ *  @param values  The transformed source value of each gene. This may be NULL if the count is 0.
+ *  @param count   The number of genes in the patch.
+ *
+ *  @return An initialized instance of the receiver.
+ */
+- (instancetype)initWithGenome:(GNKGenome *)genome options:(GNKLabOptions)options indexes:(NSUInteger *)indexes values:(__strong id *)values count:(NSUInteger)count NS_DESIGNATED_INITIALIZER __attribute((nonnull (1)));
+
+/**
+ *  A contiguous array of the positions in the genome of the genes in the patch. The array contains exactly `count` positions and is valid for the lifetime of the receiver.
+ */
+@property (assign, nonatomic, readonly) const NSUInteger *indexes;
+
+/**
+ *  A contiguous array of the values of the genes in the patch, in the same order as the positions. The array contains exactly `count` values and is valid for the lifetime of the receiver.
+ */
+@property (assign, nonatomic, readonly) __unsafe_unretained id const *values;
+
+@end
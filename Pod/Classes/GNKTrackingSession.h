@@ -0,0 +1,113 @@
+//
+//  GNKTrackingSession.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/26/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <GeneticsKit/GNKLab.h>
+
+@class GNKGenome;
+
+/**
+ *  A GNKTrackingSession observes a long-lived source object with key-value observing and keeps track of which genes of a genome may have changed, so that repeated comparisons and transfers only evaluate those genes.
+ *
+ *  When the session is created every gene is considered dirty. Comparing against a receiver clears the genes which turn out to be equivalent, and transfering to a receiver clears every gene it transfers. Afterwards, genes only become dirty again when their source key paths change, so the cost of each comparison or transfer is proportional to the number of changes rather than the size of the genome.
+ *
+ *  The session assumes the receiver is only changed through the session. If the receiver is changed elsewhere, call -markAllGenesDirty before comparing or transfering.
+ *
+ *  Source traits are observed through key paths, so the source must be key-value observing compliant for them. Genes whose source traits cannot be observed, such as identity traits, index traits, or keys with collection operators, are always evaluated.
+ *
+ *  ```
+ *  GNKTrackingSession *session = [GNKTrackingSession sessionWithSource:model genome:genome];
+ *
+ *  // On each tick:
+ *  [session transferTraitsToReceiver:viewModel options:0];
+ *  ```
+ */
+@interface GNKTrackingSession : NSObject
+
+/**
+ *  Convenience method which creates a session tracking the given source.
+ *
+ *  @see initWithSource:genome:
+ *
+ *  @param source The source object to observe. This must not be nil.
+ *  @param genome The genome whose source traits will be observed. This must not be nil.
+ *
+ *  @return A new session which has started observing the source.
+ */
++ (instancetype)sessionWithSource:(id)source genome:(GNKGenome *)genome __attribute((nonnull));
+
+/**
+ *  Initializes the receiver and starts observing the source. This is the designated initializer.
+ *
+ *  @param source The source object to observe. This must not be nil.
+ *  @param genome The genome whose source traits will be observed. This must not be nil.
+ *
+ *  @return An initialized instance of the receiver.
+ */
+- (instancetype)initWithSource:(id)source genome:(GNKGenome *)genome NS_DESIGNATED_INITIALIZER __attribute((nonnull));
+
+/**
+ *  The observed source object. The session retains its source.
+ */
+@property (strong, nonatomic, readonly) id source;
+
+/**
+ *  The genome which the session tracks.
+ */
+@property (strong, nonatomic, readonly) GNKGenome *genome;
+
+/**
+ *  The indexes of the genes in the genome which will be evaluated by the next comparison or transfer. This includes genes whose source traits cannot be observed.
+ */
+@property (copy, nonatomic, readonly) NSIndexSet *dirtyGeneIndexes;
+
+/**
+ *  Marks every gene as dirty, so the next comparison or transfer evaluates the entire genome.
+ */
+- (void)markAllGenesDirty;
+
+/**
+ *  Compares the dirty genes between the source and the receiver. Dirty genes whose values are equivalent are no longer dirty afterwards.
+ *
+ *  @see +[GNKLab findGenesWithDifferentTraitsFromSource:receiver:compiledGenome:options:]
+ *
+ *  @param receiver The receiving object which will have its trait values compared against. This must not be nil.
+ *  @param options  A bitmask of options to use when retrieving traits. Note that the GNKLabPreSettingNilConversion option is ignored.
+ *
+ *  @return The indexes of the genes in the genome which have traits that did not represent equivalent values between the source and receiver.
+ */
+- (NSIndexSet *)indexesOfGenesWithDifferentTraitsInReceiver:(id)receiver options:(GNKLabOptions)options __attribute((nonnull));
+
+/**
+ *  Compares the dirty genes between the source and the receiver. Dirty genes whose values are equivalent are no longer dirty afterwards.
+ *
+ *  @see indexesOfGenesWithDifferentTraitsInReceiver:options:
+ *
+ *  @param receiver The receiving object which will have its trait values compared against. This must not be nil.
+ *  @param options  A bitmask of options to use when retrieving traits. Note that the GNKLabPreSettingNilConversion option is ignored.
+ *
+ *  @return A set of GNKGene objects which have traits that did not represent equivalent values between the source and receiver.
+ */
+- (NSSet *)findGenesWithDifferentTraitsInReceiver:(id)receiver options:(GNKLabOptions)options __attribute((nonnull));
+
+/**
+ *  Transfers the dirty genes from the source to the receiver. No genes are dirty afterwards, unless the source changed during the transfer.
+ *
+ *  @see +[GNKLab transferTraitsFromSource:receiver:compiledGenome:options:]
+ *
+ *  @param receiver The receiving object which will have values set on it. This must not be nil.
+ *  @param options  A bitmask of options to use when transfering traits.
+ */
+- (void)transferTraitsToReceiver:(id)receiver options:(GNKLabOptions)options __attribute((nonnull));
+
+/**
+ *  Stops observing the source. Afterwards every gene is always considered dirty. This is called automatically when the session is deallocated.
+ */
+- (void)invalidate;
+
+@end
@@ -0,0 +1,252 @@
+//
+//  GNKTrackingSession.m
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/26/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import "GNKTrackingSession.h"
+#import "GNKLab_Private.h"
+#import "GNKChangeBatchingReceiver.h"
+#import "GNKGene.h"
+#import "GNKTrait_Private.h"
+#import <pthread.h>
+
+static void *GNKTrackingSessionContext = &GNKTrackingSessionContext;
+
+@implementation GNKTrackingSession
+{
+    pthread_mutex_t _lock;
+    
+    // Maps each observed key path to the indexes of the genes which depend on it.
+    NSDictionary *_geneIndexesForKeyPaths;
+    NSIndexSet *_untrackedGeneIndexes;
+    NSMutableIndexSet *_dirtyGeneIndexes;
+    BOOL _observing;
+}
+
+#pragma mark - API
+
++ (instancetype)sessionWithSource:(id)source genome:(GNKGenome *)genome
+{
+    return [[self alloc] initWithSource:source genome:genome];
+}
+
+- (instancetype)initWithSource:(id)source genome:(GNKGenome *)genome
+{
+    NSParameterAssert(source);
+    NSParameterAssert(genome);
+    
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    pthread_mutex_init(&_lock, NULL);
+    
+    _source = source;
+    _genome = genome;
+    _dirtyGeneIndexes = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, genome.count)];
+    
+    const GNKGenomeEntry *entries = genome.entries;
+    NSMutableDictionary *geneIndexesForKeyPaths = [NSMutableDictionary dictionary];
+    NSMutableIndexSet *untrackedGeneIndexes = [NSMutableIndexSet indexSet];
+    
+    for (NSUInteger i = 0; i < genome.count; i++)
+    {
+        NSArray *keyPaths = GNKTraitObservableKeyPaths(entries[i].sourceTrait);
+        if (!keyPaths)
+        {
+            [untrackedGeneIndexes addIndex:i];
+            continue;
+        }
+        
+        for (NSString *keyPath in keyPaths)
+        {
+            NSMutableIndexSet *geneIndexes = geneIndexesForKeyPaths[keyPath];
+            if (!geneIndexes)
+            {
+                geneIndexes = [NSMutableIndexSet indexSet];
+                geneIndexesForKeyPaths[keyPath] = geneIndexes;
+            }
+            
+            [geneIndexes addIndex:i];
+        }
+    }
+    
+    _geneIndexesForKeyPaths = [geneIndexesForKeyPaths copy];
+    _untrackedGeneIndexes = [untrackedGeneIndexes copy];
+    
+    for (NSString *keyPath in _geneIndexesForKeyPaths)
+    {
+        [_source addObserver:self forKeyPath:keyPath options:0 context:GNKTrackingSessionContext];
+    }
+    
+    _observing = YES;
+    
+    return self;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wobjc-designated-initializers"
+- (instancetype)init
+{
+    [self doesNotRecognizeSelector:_cmd];
+    return nil;
+}
+#pragma clang diagnostic pop
+
+- (void)dealloc
+{
+    [self invalidate];
+    pthread_mutex_destroy(&_lock);
+}
+
+- (NSIndexSet *)dirtyGeneIndexes
+{
+    pthread_mutex_lock(&_lock);
+    NSMutableIndexSet *dirtyGeneIndexes = [_dirtyGeneIndexes mutableCopy];
+    pthread_mutex_unlock(&_lock);
+    
+    [dirtyGeneIndexes addIndexes:_untrackedGeneIndexes];
+    
+    return [dirtyGeneIndexes copy];
+}
+
+- (void)markAllGenesDirty
+{
+    pthread_mutex_lock(&_lock);
+    [_dirtyGeneIndexes addIndexesInRange:NSMakeRange(0, self.genome.count)];
+    pthread_mutex_unlock(&_lock);
+}
+
+- (NSIndexSet *)indexesOfGenesWithDifferentTraitsInReceiver:(id)receiver options:(GNKLabOptions)options
+{
+    NSParameterAssert(receiver);
+    
+    id source = self.source;
+    NSIndexSet *candidateIndexes = [self takeDirtyGeneIndexes];
+    const GNKGenomeEntry *entries = self.genome.entries;
+    NSMutableIndexSet *differentIndexes = [NSMutableIndexSet indexSet];
+    
+    [candidateIndexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        if (GNKLabEntryHasDifferentTraits(source, receiver, &entries[index], options))
+        {
+            [differentIndexes addIndex:index];
+        }
+    }];
+    
+    // Genes which still differ stay dirty until they are transfered.
+    pthread_mutex_lock(&_lock);
+    [_dirtyGeneIndexes addIndexes:differentIndexes];
+    pthread_mutex_unlock(&_lock);
+    
+    return [differentIndexes copy];
+}
+
+- (NSSet *)findGenesWithDifferentTraitsInReceiver:(id)receiver options:(GNKLabOptions)options
+{
+    NSParameterAssert(receiver);
+    
+    NSIndexSet *differentIndexes = [self indexesOfGenesWithDifferentTraitsInReceiver:receiver options:options];
+    const GNKGenomeEntry *entries = self.genome.entries;
+    NSMutableSet *differentGenes = [NSMutableSet setWithCapacity:differentIndexes.count];
+    
+    [differentIndexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        [differentGenes addObject:entries[index].gene];
+    }];
+    
+    return [differentGenes copy];
+}
+
+- (void)transferTraitsToReceiver:(id)receiver options:(GNKLabOptions)options
+{
+    NSParameterAssert(receiver);
+    
+    id source = self.source;
+    NSIndexSet *candidateIndexes = [self takeDirtyGeneIndexes];
+    const GNKGenomeEntry *entries = self.genome.entries;
+    
+    __block BOOL began = NO;
+    BOOL batchesChanges = GNKLabBatchesChanges(receiver, options);
+    
+    // A raising setter must not leave the receiver inside a change batch.
+    @try
+    {
+        [candidateIndexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+            GNKLabTransferEntry(source, receiver, &entries[index], options, batchesChanges ? &began : NULL);
+        }];
+    }
+    @finally
+    {
+        if (began)
+        {
+            [(id<GNKChangeBatchingReceiver>)receiver didChangeTraits];
+        }
+    }
+}
+
+- (void)invalidate
+{
+    // Only the caller which clears the flag removes the observers, so racing invalidations never remove them twice. Every gene is marked dirty under the same lock, so no caller can take dirty indexes from an invalidated session before they are.
+    pthread_mutex_lock(&_lock);
+    BOOL wasObserving = _observing;
+    if (wasObserving)
+    {
+        _observing = NO;
+        [_dirtyGeneIndexes addIndexesInRange:NSMakeRange(0, self.genome.count)];
+    }
+    pthread_mutex_unlock(&_lock);
+    
+    if (!wasObserving)
+    {
+        return;
+    }
+    
+    for (NSString *keyPath in _geneIndexesForKeyPaths)
+    {
+        [_source removeObserver:self forKeyPath:keyPath context:GNKTrackingSessionContext];
+    }
+}
+
+
+#pragma mark - Internal
+
+/**
+ *  Returns the genes to evaluate and clears the dirty genes. They are cleared before being evaluated so that changes made while evaluating mark genes dirty again rather than being lost.
+ *
+ *  @return The indexes of the dirty genes, including genes which cannot be observed.
+ */
+- (NSIndexSet *)takeDirtyGeneIndexes
+{
+    pthread_mutex_lock(&_lock);
+    NSMutableIndexSet *dirtyGeneIndexes = _dirtyGeneIndexes;
+    // An invalidated session no longer observes changes, so every gene stays dirty.
+    _dirtyGeneIndexes = _observing ? [NSMutableIndexSet indexSet] : [dirtyGeneIndexes mutableCopy];
+    pthread_mutex_unlock(&_lock);
+    
+    [dirtyGeneIndexes addIndexes:_untrackedGeneIndexes];
+    
+    return dirtyGeneIndexes;
+}
+
+
+#pragma mark - NSKeyValueObserving
+
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context
+{
+    if (context != GNKTrackingSessionContext)
+    {
+        [super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+        return;
+    }
+    
+    NSIndexSet *geneIndexes = _geneIndexesForKeyPaths[keyPath];
+    
+    pthread_mutex_lock(&_lock);
+    [_dirtyGeneIndexes addIndexes:geneIndexes];
+    pthread_mutex_unlock(&_lock);
+}
+
+@end
@@ -86,6 +86,26 @@
  */
 @interface GNKTrait : NSObject
 
+/**
+ *  Enables or disables trait interning. Interning is disabled by default.
+ *
+ *  While interning is enabled, the class methods which create traits return a single canonical instance for each distinct trait value rather than a new instance each time. Interned traits have precomputed hashes and compare against each other by pointer, so they make sets, dictionaries, and genomes which contain them considerably cheaper to build and query. Interned traits are retained for the lifetime of the process, so interning is best suited to applications which use a bounded number of distinct traits.
+ *
+ *  Traits which were created before interning was enabled remain valid and continue to compare equal to equivalent interned traits.
+ *
+ *  @param interningEnabled YES to enable interning, NO to disable it.
+ */
++ (void)setInterningEnabled:(BOOL)interningEnabled;
+
+/**
+ *  Checks if trait interning is enabled.
+ *
+ *  @see setInterningEnabled:
+ *
+ *  @return YES if interning is enabled, NO if it is not.
+ */
++ (BOOL)isInterningEnabled;
+
 /**
  *  Creates a basic trait conforming object which will simply echo given objects as trait values.
  *
@@ -137,6 +157,8 @@
  *
  *  When getting a trait value, each trait in the traits array is enumerated, with the returned value of one trait becoming the object for the next trait. Similarly, when setting a trait value, all but the last trait in the traits array are enumerated to acquire the an object which is passed to the final trait along with the requested trait value. Because of this, only the final trait must conform to GNKReceivingTrait. All other objects need only conform to GNKSourceTrait.
  *
+ *  Any sequence traits in the traits array are flattened into the new sequence, so a sequence containing other sequences is equivalent to a single sequence of all their traits.
+ *
  *  @param traits An array of trait objects. This must contain at least one object, and the last object must be a GNKReceivingTrait conformer.
  *
  *  @return A GNKReceivingTrait conforming object which represents a sequence of other traits.
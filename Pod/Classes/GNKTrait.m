@@ -6,7 +6,18 @@
 //  Copyright (c) 2015 Zach Radke. All rights reserved.
 //
 
-#import "GNKTrait.h"
+#import "GNKTrait_Private.h"
+#import <objc/runtime.h>
+#import <pthread.h>
+
+@interface GNKTrait ()
+
+/**
+ *  YES if the receiver is the canonical instance for its value. Interned traits are only ever equal to themselves.
+ */
+@property (assign, nonatomic, getter=isInterned) BOOL interned;
+
+@end
 
 @interface _GNKIndexTrait : GNKTrait <GNKReceivingTrait>
 
@@ -46,11 +57,94 @@
 
 @end
 
+@interface _GNKAggregateValues : NSDictionary
+
+- (instancetype)initWithOwner:(id)owner slots:(__unsafe_unretained id *)slots count:(NSUInteger)count;
+
+- (void)setValue:(id)value atSlot:(NSUInteger)slot;
+
+@end
+
+@interface _GNKKeyAccessor : NSObject
+
++ (instancetype)accessorForClass:(Class)objectClass key:(NSString *)key;
+
+@property (assign, nonatomic, readonly) Class objectClass;
+@property (copy, nonatomic, readonly) NSString *key;
+
+- (id)valueFromObject:(id)object;
+- (void)setValue:(id)value onObject:(id)object;
+- (BOOL)copyScalarValueFromObject:(id)source toObject:(id)receiver accessor:(_GNKKeyAccessor *)accessor;
+
+@end
+
+
+#pragma mark - Interning
+
+static pthread_mutex_t GNKInternedTraitsLock = PTHREAD_MUTEX_INITIALIZER;
+static NSMutableSet *GNKInternedTraits;
+static volatile BOOL GNKTraitInterningEnabled = NO;
+
+id GNKTraitIntern(id trait)
+{
+    if (!GNKTraitInterningEnabled || ![trait isKindOfClass:[GNKTrait class]] || [trait isInterned])
+    {
+        return trait;
+    }
+    
+    pthread_mutex_lock(&GNKInternedTraitsLock);
+    
+    if (!GNKInternedTraits)
+    {
+        GNKInternedTraits = [NSMutableSet set];
+    }
+    
+    GNKTrait *internedTrait = [GNKInternedTraits member:trait];
+    
+    if (!internedTrait)
+    {
+        internedTrait = trait;
+        internedTrait.interned = YES;
+        [GNKInternedTraits addObject:internedTrait];
+    }
+    
+    pthread_mutex_unlock(&GNKInternedTraitsLock);
+    
+    return internedTrait;
+}
+
+static NSArray *GNKTraitInternAll(NSArray *traits)
+{
+    if (!GNKTraitInterningEnabled)
+    {
+        return traits;
+    }
+    
+    NSMutableArray *internedTraits = [NSMutableArray arrayWithCapacity:traits.count];
+    
+    for (id trait in traits)
+    {
+        [internedTraits addObject:GNKTraitIntern(trait)];
+    }
+    
+    return internedTraits;
+}
+
 
 #pragma mark - Public API
 
 @implementation GNKTrait
 
++ (void)setInterningEnabled:(BOOL)interningEnabled
+{
+    GNKTraitInterningEnabled = interningEnabled;
+}
+
++ (BOOL)isInterningEnabled
+{
+    return GNKTraitInterningEnabled;
+}
+
 + (instancetype)identityTrait
 {
     return [_GNKIdentityTrait sharedTrait];
@@ -58,22 +152,22 @@
 
 + (instancetype)aggregateOfTraits:(NSArray *)traits
 {
-    return [[_GNKAggregateTrait alloc] initWithTraits:[NSSet setWithArray:traits]];
+    return GNKTraitIntern([[_GNKAggregateTrait alloc] initWithTraits:[NSSet setWithArray:GNKTraitInternAll(traits)]]);
 }
 
 + (instancetype)traitWithKey:(NSString *)key
 {
-    return [[_GNKKeyTrait alloc] initWithKey:key];
+    return GNKTraitIntern([[_GNKKeyTrait alloc] initWithKey:key]);
 }
 
 + (instancetype)traitWithIndex:(NSInteger)index
 {
-    return [[_GNKIndexTrait alloc] initWithIndex:index];
+    return GNKTraitIntern([[_GNKIndexTrait alloc] initWithIndex:index]);
 }
 
 + (instancetype)sequenceOfTraits:(NSArray *)traits
 {
-    return [[_GNKSequenceTrait alloc] initWithSequence:traits];
+    return GNKTraitIntern([[_GNKSequenceTrait alloc] initWithSequence:GNKTraitInternAll(traits)]);
 }
 
 - (instancetype)init
@@ -96,7 +190,126 @@
 
 #pragma mark - GNKIndexTrait
 
+typedef NS_OPTIONS(NSUInteger, _GNKIndexCapabilities)
+{
+    _GNKIndexCapabilityResolved = 1 << 0,
+    _GNKIndexCapabilityCount = 1 << 1,
+    _GNKIndexCapabilitySubscripting = 1 << 2,
+    _GNKIndexCapabilityObjectAtIndex = 1 << 3,
+    _GNKIndexCapabilityMutableArray = 1 << 4
+};
+
+/**
+ *  The capabilities resolved for a single class. Records are never deallocated once resolved, so index traits can hold the last one they used without retaining it.
+ */
+typedef struct
+{
+    Class objectClass;
+    _GNKIndexCapabilities capabilities;
+    
+    /**
+     *  YES if instances of the class may answer -respondsToSelector: differently from their class, as proxies do, in which case capabilities are resolved for each object.
+     */
+    BOOL resolvesPerObject;
+} _GNKIndexCapabilitiesRecord;
+
+/**
+ *  Returns which indexed collection methods the object responds to.
+ */
+static _GNKIndexCapabilities GNKResolveIndexCapabilities(id object)
+{
+    _GNKIndexCapabilities capabilities = _GNKIndexCapabilityResolved;
+    
+    if ([object respondsToSelector:@selector(count)])
+    {
+        capabilities |= _GNKIndexCapabilityCount;
+    }
+    
+    if ([object respondsToSelector:@selector(objectAtIndexedSubscript:)])
+    {
+        capabilities |= _GNKIndexCapabilitySubscripting;
+    }
+    
+    if ([object respondsToSelector:@selector(objectAtIndex:)])
+    {
+        capabilities |= _GNKIndexCapabilityObjectAtIndex;
+    }
+    
+    if ([object isKindOfClass:[NSMutableArray class]])
+    {
+        capabilities |= _GNKIndexCapabilityMutableArray;
+    }
+    
+    return capabilities;
+}
+
+/**
+ *  Returns the record for the object's class, resolving it from the object the first time the class is seen. Records are only looked up when a trait sees a different class than it last did, so the lock is rarely taken.
+ */
+static const _GNKIndexCapabilitiesRecord *GNKIndexCapabilitiesRecordForObject(id object)
+{
+    static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    static NSMapTable *recordsForClasses;
+    
+    Class objectClass = object_getClass(object);
+    
+    pthread_mutex_lock(&lock);
+    
+    if (!recordsForClasses)
+    {
+        recordsForClasses = [NSMapTable mapTableWithKeyOptions:(NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality)
+                                                  valueOptions:(NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality)];
+    }
+    
+    _GNKIndexCapabilitiesRecord *record = (__bridge void *)[recordsForClasses objectForKey:objectClass];
+    
+    if (!record)
+    {
+        record = malloc(sizeof(_GNKIndexCapabilitiesRecord));
+        record->objectClass = objectClass;
+        
+        // Proxies and classes which override -respondsToSelector: may answer differently for each instance.
+        record->resolvesPerObject = class_getMethodImplementation(objectClass, @selector(respondsToSelector:)) != class_getMethodImplementation([NSObject class], @selector(respondsToSelector:));
+        record->capabilities = record->resolvesPerObject ? 0 : GNKResolveIndexCapabilities(object);
+        
+        [recordsForClasses setObject:(__bridge id)(void *)record forKey:objectClass];
+    }
+    
+    pthread_mutex_unlock(&lock);
+    
+    return record;
+}
+
+/**
+ *  Returns an array of the given number of NSNull objects, optionally followed by a value.
+ */
+static NSArray *GNKPaddedArray(NSUInteger paddingCount, id value)
+{
+    NSUInteger count = paddingCount + (value ? 1 : 0);
+    __unsafe_unretained id *objects = (__unsafe_unretained id *)malloc(count * sizeof(id));
+    
+    id null = [NSNull null];
+    for (NSUInteger i = 0; i < paddingCount; i++)
+    {
+        objects[i] = null;
+    }
+    
+    if (value)
+    {
+        objects[paddingCount] = value;
+    }
+    
+    NSArray *array = [[NSArray alloc] initWithObjects:objects count:count];
+    free(objects);
+    
+    return array;
+}
+
 @implementation _GNKIndexTrait
+{
+    // Read and written atomically, since traits are shared between threads. Records are immortal, so a stale record is never dangling.
+    const _GNKIndexCapabilitiesRecord *_lastCapabilities;
+}
 
 - (instancetype)initWithIndex:(NSInteger)index
 {
@@ -130,7 +343,9 @@
     {
         return YES;
     }
-    else if (![object isKindOfClass:[self class]])
+    else if (![object isKindOfClass:[self class]] ||
+             (self.isInterned && [object isInterned]) ||
+             self.hash != [object hash])
     {
         return NO;
     }
@@ -152,14 +367,44 @@
 }
 
 
+#pragma mark Capabilities
+
+/**
+ *  Returns which indexed collection methods the object responds to. The record for the last class seen is cached, so objects of the same class as the previous one are checked without taking a lock or sending any message.
+ */
+- (_GNKIndexCapabilities)capabilitiesForObject:(id)object
+{
+    if (!object)
+    {
+        return 0;
+    }
+    
+    const _GNKIndexCapabilitiesRecord *record = __atomic_load_n(&_lastCapabilities, __ATOMIC_ACQUIRE);
+    
+    if (!record || record->objectClass != object_getClass(object))
+    {
+        record = GNKIndexCapabilitiesRecordForObject(object);
+        __atomic_store_n(&_lastCapabilities, record, __ATOMIC_RELEASE);
+    }
+    
+    return record->resolvesPerObject ? GNKResolveIndexCapabilities(object) : record->capabilities;
+}
+
+
 #pragma mark GNKSourceTrait
 
 - (id)traitValueFromObject:(id)object
 {
-    if ([object respondsToSelector:@selector(count)] && [object count] <= self.index)
+    _GNKIndexCapabilities capabilities = [self capabilitiesForObject:object];
+    
+    if ((capabilities & _GNKIndexCapabilityCount) && [object count] <= (NSUInteger)self.index)
     {
         return nil;
     }
+    else if (!(capabilities & _GNKIndexCapabilitySubscripting) && (capabilities & _GNKIndexCapabilityObjectAtIndex))
+    {
+        return [object objectAtIndex:self.index];
+    }
     
     return object[self.index];
 }
@@ -169,15 +414,34 @@
 
 - (void)setTraitValue:(id)traitValue onObject:(id)object
 {
-    if ([object respondsToSelector:@selector(count)])
+    _GNKIndexCapabilities capabilities = [self capabilitiesForObject:object];
+    NSUInteger index = self.index;
+    
+    if (capabilities & _GNKIndexCapabilityMutableArray)
+    {
+        NSMutableArray *array = object;
+        NSUInteger count = array.count;
+        
+        if (count < index && traitValue)
+        {
+            // Padding and the value itself are inserted together, so the array grows to its final size at once.
+            [array replaceObjectsInRange:NSMakeRange(count, 0) withObjectsFromArray:GNKPaddedArray(index - count, traitValue)];
+            return;
+        }
+        else if (count < index)
+        {
+            [array replaceObjectsInRange:NSMakeRange(count, 0) withObjectsFromArray:GNKPaddedArray(index - count, nil)];
+        }
+    }
+    else if (capabilities & _GNKIndexCapabilityCount)
     {
-        for (NSUInteger i = [object count]; i < self.index; i++)
+        for (NSUInteger i = [object count]; i < index; i++)
         {
             object[i] = [NSNull null];
         }
     }
     
-    object[self.index] = traitValue;
+    object[index] = traitValue;
 }
 
 @end
@@ -186,6 +450,17 @@
 #pragma mark - GNKKeyTrait
 
 @implementation _GNKKeyTrait
+{
+    NSUInteger _hash;
+    NSArray *_segments;
+    NSUInteger _segmentCount;
+    
+    // Accessors are never deallocated once resolved, so the last one used for each segment can be held without retaining it. Entries are read and written atomically, since traits are shared between threads.
+    __unsafe_unretained _GNKKeyAccessor **_lastAccessors;
+    
+    // Key paths with collection operators are left entirely to key-value coding.
+    BOOL _usesKeyPathOperators;
+}
 
 - (instancetype)initWithKey:(NSString *)key
 {
@@ -197,6 +472,11 @@
     }
     
     _key = [key copy];
+    _hash = _key.hash;
+    _usesKeyPathOperators = [_key rangeOfString:@"@"].location != NSNotFound;
+    _segments = [_key componentsSeparatedByString:@"."];
+    _segmentCount = _segments.count;
+    _lastAccessors = (__unsafe_unretained _GNKKeyAccessor **)calloc(_segmentCount, sizeof(_GNKKeyAccessor *));
     
     return self;
 }
@@ -207,6 +487,38 @@
     return nil;
 }
 
+- (void)dealloc
+{
+    free(_lastAccessors);
+}
+
+- (_GNKKeyAccessor *)accessorForObject:(id)object segment:(NSUInteger)segment
+{
+    Class objectClass = object_getClass(object);
+    _GNKKeyAccessor *accessor = __atomic_load_n(&_lastAccessors[segment], __ATOMIC_ACQUIRE);
+    
+    if (accessor.objectClass != objectClass)
+    {
+        accessor = [_GNKKeyAccessor accessorForClass:objectClass key:_segments[segment]];
+        __atomic_store_n(&_lastAccessors[segment], accessor, __ATOMIC_RELEASE);
+    }
+    
+    return accessor;
+}
+
+/**
+ *  Walks all but the last segment of the key path, returning the object which owns the final key. This mirrors how -valueForKeyPath: and -setValue:forKeyPath: recurse one key at a time.
+ */
+- (id)parentObjectFromObject:(id)object
+{
+    for (NSUInteger segment = 0; segment + 1 < _segmentCount && object; segment++)
+    {
+        object = [[self accessorForObject:object segment:segment] valueFromObject:object];
+    }
+    
+    return object;
+}
+
 
 #pragma mark NSObject
 
@@ -221,7 +533,9 @@
     {
         return YES;
     }
-    else if (![object isKindOfClass:[self class]])
+    else if (![object isKindOfClass:[self class]] ||
+             (self.isInterned && [object isInterned]) ||
+             self.hash != [object hash])
     {
         return NO;
     }
@@ -231,7 +545,7 @@
 
 - (NSUInteger)hash
 {
-    return self.key.hash;
+    return _hash;
 }
 
 
@@ -247,7 +561,19 @@
 
 - (id)traitValueFromObject:(id)object
 {
-    return [object valueForKeyPath:self.key];
+    if (_usesKeyPathOperators)
+    {
+        return [object valueForKeyPath:self.key];
+    }
+    
+    object = [self parentObjectFromObject:object];
+    
+    if (!object)
+    {
+        return nil;
+    }
+    
+    return [[self accessorForObject:object segment:_segmentCount - 1] valueFromObject:object];
 }
 
 
@@ -255,15 +581,174 @@
 
 - (void)setTraitValue:(id)traitValue onObject:(id)object
 {
-    [object setValue:traitValue forKeyPath:self.key];
+    if (_usesKeyPathOperators)
+    {
+        [object setValue:traitValue forKeyPath:self.key];
+        return;
+    }
+    
+    object = [self parentObjectFromObject:object];
+    
+    if (!object)
+    {
+        return;
+    }
+    
+    [[self accessorForObject:object segment:_segmentCount - 1] setValue:traitValue onObject:object];
+}
+
+
+#pragma mark Scalars
+
+- (BOOL)copyScalarValueFromObject:(id)source toObject:(id)receiver receivingTrait:(_GNKKeyTrait *)receivingTrait
+{
+    if (_usesKeyPathOperators || receivingTrait->_usesKeyPathOperators)
+    {
+        return NO;
+    }
+    
+    source = [self parentObjectFromObject:source];
+    receiver = [receivingTrait parentObjectFromObject:receiver];
+    
+    if (!source || !receiver)
+    {
+        return NO;
+    }
+    
+    _GNKKeyAccessor *getter = [self accessorForObject:source segment:_segmentCount - 1];
+    _GNKKeyAccessor *setter = [receivingTrait accessorForObject:receiver segment:receivingTrait->_segmentCount - 1];
+    
+    return [getter copyScalarValueFromObject:source toObject:receiver accessor:setter];
 }
 
 @end
 
 
+BOOL GNKTraitIsKeyTrait(id trait)
+{
+    return [trait isMemberOfClass:[_GNKKeyTrait class]];
+}
+
+BOOL GNKTraitCopyScalarValue(id sourceTrait, id source, id receivingTrait, id receiver)
+{
+    NSCParameterAssert(GNKTraitIsKeyTrait(sourceTrait));
+    NSCParameterAssert(GNKTraitIsKeyTrait(receivingTrait));
+    
+    if (!source || !receiver)
+    {
+        return NO;
+    }
+    
+    return [(_GNKKeyTrait *)sourceTrait copyScalarValueFromObject:source toObject:receiver receivingTrait:receivingTrait];
+}
+
+NSArray *GNKTraitSequence(id trait)
+{
+    return [trait isKindOfClass:[_GNKSequenceTrait class]] ? [trait sequence] : nil;
+}
+
+NSArray *GNKTraitPathComponents(id trait)
+{
+    if (GNKTraitIsKeyTrait(trait))
+    {
+        NSString *key = [trait key];
+        return ([key rangeOfString:@"@"].location == NSNotFound) ? [key componentsSeparatedByString:@"."] : nil;
+    }
+    else if ([trait isKindOfClass:[_GNKIndexTrait class]])
+    {
+        return ([trait index] >= 0) ? @[@([trait index])] : nil;
+    }
+    else if ([trait isKindOfClass:[_GNKSequenceTrait class]])
+    {
+        NSMutableArray *components = [NSMutableArray array];
+        
+        // Sequences are flattened, so none of their traits are sequences themselves.
+        for (id sequenceTrait in [trait sequence])
+        {
+            NSArray *sequenceComponents = GNKTraitPathComponents(sequenceTrait);
+            if (!sequenceComponents)
+            {
+                return nil;
+            }
+            
+            [components addObjectsFromArray:sequenceComponents];
+        }
+        
+        return [components copy];
+    }
+    
+    return nil;
+}
+
+id GNKTraitCollectionComponent(id trait)
+{
+    if (GNKTraitIsKeyTrait(trait))
+    {
+        NSString *key = [trait key];
+        return ([key rangeOfString:@"."].location == NSNotFound && [key rangeOfString:@"@"].location == NSNotFound) ? key : nil;
+    }
+    else if ([trait isKindOfClass:[_GNKIndexTrait class]])
+    {
+        return ([trait index] >= 0) ? @([trait index]) : nil;
+    }
+    
+    return nil;
+}
+
+NSArray *GNKTraitObservableKeyPaths(id trait)
+{
+    if (GNKTraitIsKeyTrait(trait) || [trait isKindOfClass:[_GNKIndexTrait class]] || [trait isKindOfClass:[_GNKSequenceTrait class]])
+    {
+        NSMutableArray *keys = [GNKTraitPathComponents(trait) mutableCopy];
+        
+        // Mutating an indexed collection notifies observers of its key path, so a single trailing index can be observed.
+        if ([keys.lastObject isKindOfClass:[NSNumber class]])
+        {
+            [keys removeLastObject];
+        }
+        
+        for (id key in keys)
+        {
+            if (![key isKindOfClass:[NSString class]])
+            {
+                return nil;
+            }
+        }
+        
+        return (keys.count > 0) ? @[[keys componentsJoinedByString:@"."]] : nil;
+    }
+    else if ([trait isKindOfClass:[_GNKAggregateTrait class]])
+    {
+        NSMutableArray *keyPaths = [NSMutableArray array];
+        
+        for (id aggregatedTrait in [trait traits])
+        {
+            NSArray *aggregatedKeyPaths = GNKTraitObservableKeyPaths(aggregatedTrait);
+            if (!aggregatedKeyPaths)
+            {
+                return nil;
+            }
+            
+            [keyPaths addObjectsFromArray:aggregatedKeyPaths];
+        }
+        
+        return [keyPaths copy];
+    }
+    
+    return nil;
+}
+
+
 #pragma mark - GNKSequenceTrait
 
 @implementation _GNKSequenceTrait
+{
+    NSUInteger _hash;
+    
+    // The sequence retains the traits, so they can be walked without retaining them again.
+    __unsafe_unretained id *_traits;
+    NSUInteger _count;
+}
 
 - (instancetype)initWithSequence:(NSArray *)traits
 {
@@ -274,7 +759,30 @@
         return nil;
     }
     
-    _sequence = [traits copy];
+    // Nested sequences are spliced in place, since walking them is equivalent to walking their traits directly.
+    NSMutableArray *sequence = [NSMutableArray arrayWithCapacity:traits.count];
+    for (id trait in traits)
+    {
+        if ([trait isKindOfClass:[_GNKSequenceTrait class]])
+        {
+            [sequence addObjectsFromArray:[trait sequence]];
+        }
+        else
+        {
+            [sequence addObject:trait];
+        }
+    }
+    
+    _sequence = [sequence copy];
+    _count = _sequence.count;
+    _traits = (__unsafe_unretained id *)calloc(_count, sizeof(id));
+    [_sequence getObjects:_traits range:NSMakeRange(0, _count)];
+    
+    // Unlike NSArray's hash, this accounts for every trait and their order.
+    for (NSUInteger i = 0; i < _count; i++)
+    {
+        _hash = (_hash * 31) + [_traits[i] hash];
+    }
     
     return self;
 }
@@ -285,6 +793,11 @@
     return nil;
 }
 
+- (void)dealloc
+{
+    free(_traits);
+}
+
 
 #pragma mark NSObject
 
@@ -299,7 +812,9 @@
     {
         return YES;
     }
-    else if (![object isKindOfClass:[self class]])
+    else if (![object isKindOfClass:[self class]] ||
+             (self.isInterned && [object isInterned]) ||
+             self.hash != [object hash])
     {
         return NO;
     }
@@ -309,7 +824,7 @@
 
 - (NSUInteger)hash
 {
-    return self.sequence.hash;
+    return _hash;
 }
 
 
@@ -327,9 +842,9 @@
 {
     id traitValue = object;
     
-    for (id<GNKSourceTrait> trait in self.sequence)
+    for (NSUInteger i = 0; i < _count; i++)
     {
-        traitValue = [trait traitValueFromObject:traitValue];
+        traitValue = [_traits[i] traitValueFromObject:traitValue];
     }
     
     return traitValue;
@@ -340,12 +855,12 @@
 
 - (void)setTraitValue:(id)traitValue onObject:(id)object
 {
-    for (id<GNKSourceTrait> trait in [self.sequence subarrayWithRange:NSMakeRange(0, self.sequence.count - 1)])
+    for (NSUInteger i = 0; i + 1 < _count; i++)
     {
-        object = [trait traitValueFromObject:object];
+        object = [_traits[i] traitValueFromObject:object];
     }
     
-    [self.sequence.lastObject setTraitValue:traitValue onObject:object];
+    [_traits[_count - 1] setTraitValue:traitValue onObject:object];
 }
 
 @end
@@ -354,6 +869,13 @@
 #pragma mark - GNKAggregateTrait
 
 @implementation _GNKAggregateTrait
+{
+    NSUInteger _hash;
+    
+    // Each trait is assigned a fixed slot, which is used to store its value in the returned _GNKAggregateValues.
+    __unsafe_unretained id *_slots;
+    NSUInteger _slotCount;
+}
 
 - (instancetype)initWithTraits:(NSSet *)traits
 {
@@ -365,6 +887,15 @@
     }
     
     _traits = [traits copy];
+    _slotCount = _traits.count;
+    _slots = (__unsafe_unretained id *)calloc(_slotCount, sizeof(id));
+    [[_traits allObjects] getObjects:_slots range:NSMakeRange(0, _slotCount)];
+    
+    // Unlike NSSet's hash, this accounts for every trait regardless of their order.
+    for (NSUInteger i = 0; i < _slotCount; i++)
+    {
+        _hash ^= [_slots[i] hash];
+    }
     
     return self;
 }
@@ -375,6 +906,11 @@
     return nil;
 }
 
+- (void)dealloc
+{
+    free(_slots);
+}
+
 
 #pragma mark NSObject
 
@@ -396,7 +932,9 @@
     {
         return YES;
     }
-    else if (![object isKindOfClass:[self class]])
+    else if (![object isKindOfClass:[self class]] ||
+             (self.isInterned && [object isInterned]) ||
+             self.hash != [object hash])
     {
         return NO;
     }
@@ -406,7 +944,7 @@
 
 - (NSUInteger)hash
 {
-    return self.traits.hash;
+    return _hash;
 }
 
 
@@ -422,25 +960,19 @@
 
 - (id)traitValueFromObject:(id)object
 {
-    NSMutableDictionary *traitsForTraitValues = [NSMutableDictionary dictionary];
+    _GNKAggregateValues *traitValues = [[_GNKAggregateValues alloc] initWithOwner:self slots:_slots count:_slotCount];
     
-    id traitValue;
-    for (id<GNKSourceTrait> trait in self.traits)
+    for (NSUInteger i = 0; i < _slotCount; i++)
     {
-        traitValue = [trait traitValueFromObject:object];
-        
-        if (traitValue)
-        {
-            traitsForTraitValues[trait] = traitValue;
-        }
+        [traitValues setValue:[_slots[i] traitValueFromObject:object] atSlot:i];
     }
     
-    if (traitsForTraitValues.count == 0)
+    if (traitValues.count == 0)
     {
         return nil;
     }
     
-    return [traitsForTraitValues copy];
+    return traitValues;
 }
 
 @end
@@ -487,3 +1019,463 @@
 
 @end
 
+
+#pragma mark - GNKKeyAccessor
+
+typedef NS_ENUM(NSInteger, _GNKKeyAccessorKind)
+{
+    _GNKKeyAccessorKindKeyValueCoding = 0,
+    _GNKKeyAccessorKindMethod,
+    _GNKKeyAccessorKindScalarMethod,
+    _GNKKeyAccessorKindInstanceVariable
+};
+
+static BOOL GNKTypeIsScalar(char type)
+{
+    return type != '\0' && strchr("cCsSiIlLqQfdB", type) != NULL;
+}
+
+static BOOL GNKClassOverridesSelector(Class objectClass, SEL selector)
+{
+    return class_getMethodImplementation(objectClass, selector) != class_getMethodImplementation([NSObject class], selector);
+}
+
+static BOOL GNKInstanceVariableIsWeak(Class objectClass, Ivar instanceVariable)
+{
+    for (Class cls = objectClass; cls; cls = class_getSuperclass(cls))
+    {
+        unsigned int count = 0;
+        Ivar *instanceVariables = class_copyIvarList(cls, &count);
+        
+        BOOL declared = NO;
+        for (unsigned int i = 0; i < count && !declared; i++)
+        {
+            declared = (instanceVariables[i] == instanceVariable);
+        }
+        free(instanceVariables);
+        
+        if (declared)
+        {
+            return class_getWeakIvarLayout(cls) != NULL;
+        }
+    }
+    
+    return YES;
+}
+
+/**
+ *  Resolves the accessors key-value coding would use for a single key on a single class, following the same search order as -valueForKey: and -setValue:forKey:. Object typed accessors are used directly. Scalar typed accessor methods are only used directly to copy unboxed values between accessors of the same type, and are otherwise left to key-value coding for boxing. Anything else, including classes which customize key-value coding like NSDictionary or proxies, falls back to key-value coding.
+ */
+@implementation _GNKKeyAccessor
+{
+    _GNKKeyAccessorKind _getterKind;
+    SEL _getterSelector;
+    IMP _getterImplementation;
+    Ivar _getterInstanceVariable;
+    char _getterScalarType;
+    
+    _GNKKeyAccessorKind _setterKind;
+    SEL _setterSelector;
+    IMP _setterImplementation;
+    char _setterScalarType;
+}
+
++ (instancetype)accessorForClass:(Class)objectClass key:(NSString *)key
+{
+    static NSMapTable *accessorsForClasses;
+    static dispatch_queue_t accessorsQueue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        accessorsForClasses = [NSMapTable mapTableWithKeyOptions:(NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality)
+                                                    valueOptions:NSPointerFunctionsStrongMemory];
+        accessorsQueue = dispatch_queue_create("com.zachradke.GeneticsKit.keyAccessors", DISPATCH_QUEUE_CONCURRENT);
+    });
+    
+    __block _GNKKeyAccessor *accessor;
+    dispatch_sync(accessorsQueue, ^{
+        accessor = [accessorsForClasses objectForKey:objectClass][key];
+    });
+    
+    if (accessor)
+    {
+        return accessor;
+    }
+    
+    _GNKKeyAccessor *resolvedAccessor = [[self alloc] initWithClass:objectClass key:key];
+    
+    dispatch_barrier_sync(accessorsQueue, ^{
+        NSMutableDictionary *accessors = [accessorsForClasses objectForKey:objectClass];
+        if (!accessors)
+        {
+            accessors = [NSMutableDictionary dictionary];
+            [accessorsForClasses setObject:accessors forKey:objectClass];
+        }
+        
+        // Another thread may have resolved the same accessor in the meantime, in which case the first one wins.
+        accessor = accessors[key];
+        if (!accessor)
+        {
+            accessor = resolvedAccessor;
+            accessors[key] = accessor;
+        }
+    });
+    
+    return accessor;
+}
+
+- (instancetype)initWithClass:(Class)objectClass key:(NSString *)key
+{
+    NSParameterAssert(objectClass);
+    NSParameterAssert(key);
+    
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    _objectClass = objectClass;
+    _key = [key copy];
+    
+    if (_key.length > 0)
+    {
+        [self resolveGetter];
+        [self resolveSetter];
+    }
+    
+    return self;
+}
+
+- (void)resolveGetter
+{
+    Class objectClass = self.objectClass;
+    
+    if (GNKClassOverridesSelector(objectClass, @selector(valueForKey:)))
+    {
+        return;
+    }
+    
+    NSString *key = self.key;
+    NSString *capitalizedKey = [[[key substringToIndex:1] uppercaseString] stringByAppendingString:[key substringFromIndex:1]];
+    
+    for (NSString *name in @[[@"get" stringByAppendingString:capitalizedKey], key, [@"is" stringByAppendingString:capitalizedKey], [@"_" stringByAppendingString:key]])
+    {
+        SEL selector = NSSelectorFromString(name);
+        Method method = class_getInstanceMethod(objectClass, selector);
+        
+        if (!method)
+        {
+            continue;
+        }
+        
+        char returnType[16];
+        method_getReturnType(method, returnType, sizeof(returnType));
+        
+        if (method_getNumberOfArguments(method) == 2 && returnType[0] == '@')
+        {
+            _getterKind = _GNKKeyAccessorKindMethod;
+            _getterSelector = selector;
+            _getterImplementation = method_getImplementation(method);
+        }
+        else if (method_getNumberOfArguments(method) == 2 && GNKTypeIsScalar(returnType[0]) && returnType[1] == '\0')
+        {
+            _getterKind = _GNKKeyAccessorKindScalarMethod;
+            _getterSelector = selector;
+            _getterImplementation = method_getImplementation(method);
+            _getterScalarType = returnType[0];
+        }
+        
+        return;
+    }
+    
+    // Collection accessors are left to key-value coding, which builds the appropriate proxy collection.
+    if (class_getInstanceMethod(objectClass, NSSelectorFromString([@"countOf" stringByAppendingString:capitalizedKey])) ||
+        ![objectClass accessInstanceVariablesDirectly])
+    {
+        return;
+    }
+    
+    for (NSString *name in @[[@"_" stringByAppendingString:key], [@"_is" stringByAppendingString:capitalizedKey], key, [@"is" stringByAppendingString:capitalizedKey]])
+    {
+        Ivar instanceVariable = class_getInstanceVariable(objectClass, name.UTF8String);
+        
+        if (!instanceVariable)
+        {
+            continue;
+        }
+        
+        const char *type = ivar_getTypeEncoding(instanceVariable);
+        
+        if (type && type[0] == '@' && !GNKInstanceVariableIsWeak(objectClass, instanceVariable))
+        {
+            _getterKind = _GNKKeyAccessorKindInstanceVariable;
+            _getterInstanceVariable = instanceVariable;
+        }
+        
+        return;
+    }
+}
+
+- (void)resolveSetter
+{
+    Class objectClass = self.objectClass;
+    
+    if (GNKClassOverridesSelector(objectClass, @selector(setValue:forKey:)))
+    {
+        return;
+    }
+    
+    NSString *key = self.key;
+    NSString *capitalizedKey = [[[key substringToIndex:1] uppercaseString] stringByAppendingString:[key substringFromIndex:1]];
+    
+    // Setting instance variables directly is left to key-value coding, which handles their memory management.
+    for (NSString *name in @[[NSString stringWithFormat:@"set%@:", capitalizedKey], [NSString stringWithFormat:@"_set%@:", capitalizedKey]])
+    {
+        SEL selector = NSSelectorFromString(name);
+        Method method = class_getInstanceMethod(objectClass, selector);
+        
+        if (!method)
+        {
+            continue;
+        }
+        
+        char argumentType[16];
+        method_getArgumentType(method, 2, argumentType, sizeof(argumentType));
+        
+        if (method_getNumberOfArguments(method) == 3 && argumentType[0] == '@')
+        {
+            _setterKind = _GNKKeyAccessorKindMethod;
+            _setterSelector = selector;
+            _setterImplementation = method_getImplementation(method);
+        }
+        else if (method_getNumberOfArguments(method) == 3 && GNKTypeIsScalar(argumentType[0]) && argumentType[1] == '\0')
+        {
+            _setterKind = _GNKKeyAccessorKindScalarMethod;
+            _setterSelector = selector;
+            _setterImplementation = method_getImplementation(method);
+            _setterScalarType = argumentType[0];
+        }
+        
+        return;
+    }
+}
+
+- (id)valueFromObject:(id)object
+{
+    switch (_getterKind)
+    {
+        case _GNKKeyAccessorKindMethod:
+            return ((id (*)(id, SEL))_getterImplementation)(object, _getterSelector);
+        case _GNKKeyAccessorKindInstanceVariable:
+            return object_getIvar(object, _getterInstanceVariable);
+        case _GNKKeyAccessorKindScalarMethod:
+        case _GNKKeyAccessorKindKeyValueCoding:
+        default:
+            return [object valueForKey:self.key];
+    }
+}
+
+- (void)setValue:(id)value onObject:(id)object
+{
+    switch (_setterKind)
+    {
+        case _GNKKeyAccessorKindMethod:
+            ((void (*)(id, SEL, id))_setterImplementation)(object, _setterSelector, value);
+            break;
+        case _GNKKeyAccessorKindScalarMethod:
+        case _GNKKeyAccessorKindKeyValueCoding:
+        default:
+            [object setValue:value forKey:self.key];
+            break;
+    }
+}
+
+- (BOOL)copyScalarValueFromObject:(id)source toObject:(id)receiver accessor:(_GNKKeyAccessor *)accessor
+{
+    if (_getterKind != _GNKKeyAccessorKindScalarMethod ||
+        accessor->_setterKind != _GNKKeyAccessorKindScalarMethod ||
+        _getterScalarType != accessor->_setterScalarType)
+    {
+        return NO;
+    }
+    
+#define GNK_COPY_SCALAR(TYPE) ((void (*)(id, SEL, TYPE))accessor->_setterImplementation)(receiver, accessor->_setterSelector, ((TYPE (*)(id, SEL))_getterImplementation)(source, _getterSelector))
+    
+    switch (_getterScalarType)
+    {
+        case 'c': GNK_COPY_SCALAR(char); return YES;
+        case 'C': GNK_COPY_SCALAR(unsigned char); return YES;
+        case 's': GNK_COPY_SCALAR(short); return YES;
+        case 'S': GNK_COPY_SCALAR(unsigned short); return YES;
+        case 'i': GNK_COPY_SCALAR(int); return YES;
+        case 'I': GNK_COPY_SCALAR(unsigned int); return YES;
+        case 'l': GNK_COPY_SCALAR(long); return YES;
+        case 'L': GNK_COPY_SCALAR(unsigned long); return YES;
+        case 'q': GNK_COPY_SCALAR(long long); return YES;
+        case 'Q': GNK_COPY_SCALAR(unsigned long long); return YES;
+        case 'f': GNK_COPY_SCALAR(float); return YES;
+        case 'd': GNK_COPY_SCALAR(double); return YES;
+        case 'B': GNK_COPY_SCALAR(bool); return YES;
+        default: return NO;
+    }
+    
+#undef GNK_COPY_SCALAR
+}
+
+@end
+
+
+#pragma mark - GNKAggregateValues
+
+enum
+{
+    _GNKAggregateValuesInlineCapacity = 4
+};
+
+/**
+ *  Immutable dictionary of aggregate trait values, keyed by the aggregate's traits. Values are stored in the slots assigned by the aggregate, so looking up a value by one of the aggregate's own traits is a pointer comparison. Small aggregates store their values inline, so creating them costs a single allocation.
+ */
+@implementation _GNKAggregateValues
+{
+    // The owner retains the traits referenced by the slots.
+    id _owner;
+    __unsafe_unretained id *_slots;
+    NSUInteger _slotCount;
+    
+    __strong id *_values;
+    __strong id _inlineValues[_GNKAggregateValuesInlineCapacity];
+    NSUInteger _count;
+}
+
+- (instancetype)initWithOwner:(id)owner slots:(__unsafe_unretained id *)slots count:(NSUInteger)count
+{
+    NSParameterAssert(owner);
+    NSParameterAssert(slots);
+    NSParameterAssert(count > 0);
+    
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+    
+    _owner = owner;
+    _slots = slots;
+    _slotCount = count;
+    _values = (_slotCount <= _GNKAggregateValuesInlineCapacity) ? _inlineValues : (__strong id *)calloc(_slotCount, sizeof(id));
+    
+    return self;
+}
+
+// NSDictionary's -init forwards to this primitive initializer, which must not be forwarded to the abstract class.
+- (instancetype)initWithObjects:(const id [])objects forKeys:(const id<NSCopying> [])keys count:(NSUInteger)count
+{
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_values != _inlineValues)
+    {
+        for (NSUInteger i = 0; i < _slotCount; i++)
+        {
+            _values[i] = nil;
+        }
+        
+        free(_values);
+    }
+}
+
+- (void)setValue:(id)value atSlot:(NSUInteger)slot
+{
+    NSParameterAssert(slot < _slotCount);
+    
+    if (!_values[slot] && value)
+    {
+        _count++;
+    }
+    else if (_values[slot] && !value)
+    {
+        _count--;
+    }
+    
+    _values[slot] = value;
+}
+
+
+#pragma mark NSDictionary
+
+- (NSUInteger)count
+{
+    return _count;
+}
+
+- (id)objectForKey:(id)key
+{
+    for (NSUInteger i = 0; i < _slotCount; i++)
+    {
+        if (_slots[i] == key)
+        {
+            return _values[i];
+        }
+    }
+    
+    for (NSUInteger i = 0; i < _slotCount; i++)
+    {
+        if ([_slots[i] isEqual:key])
+        {
+            return _values[i];
+        }
+    }
+    
+    return nil;
+}
+
+- (NSEnumerator *)keyEnumerator
+{
+    NSMutableArray *keys = [NSMutableArray arrayWithCapacity:_count];
+    
+    for (NSUInteger i = 0; i < _slotCount; i++)
+    {
+        if (_values[i])
+        {
+            [keys addObject:_slots[i]];
+        }
+    }
+    
+    return [keys objectEnumerator];
+}
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state objects:(id __unsafe_unretained [])buffer count:(NSUInteger)len
+{
+    if (state->state == 0)
+    {
+        // The receiver is immutable, so the mutation counter never changes.
+        static unsigned long mutations = 0;
+        state->mutationsPtr = &mutations;
+    }
+    
+    NSUInteger count = 0;
+    NSUInteger slot = state->state;
+    
+    for (; slot < _slotCount && count < len; slot++)
+    {
+        if (_values[slot])
+        {
+            buffer[count++] = _slots[slot];
+        }
+    }
+    
+    state->state = slot;
+    state->itemsPtr = buffer;
+    
+    return count;
+}
+
+
+#pragma mark NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    return self;
+}
+
+@end
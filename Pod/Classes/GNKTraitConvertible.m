@@ -7,6 +7,7 @@
 //
 
 #import "GNKTraitConvertible.h"
+#import "GNKTrait_Private.h"
 
 @implementation NSString (GeneticsKit)
 
@@ -21,6 +22,30 @@
 }
 
 - (id)_GNKTraitValue
+{
+    // Traits are immutable, so the trait parsed from a string can be shared by every conversion of an equal string.
+    static NSCache *traitsForStrings;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        traitsForStrings = [NSCache new];
+        traitsForStrings.name = @"com.zachradke.GeneticsKit.stringTraits";
+        traitsForStrings.countLimit = 1024;
+    });
+    
+    id trait = [traitsForStrings objectForKey:self];
+    
+    if (!trait)
+    {
+        // Invalid strings are cached as well, using NSNull in place of nil.
+        trait = [self _GNKParsedTraitValue] ?: [NSNull null];
+        [traitsForStrings setObject:trait forKey:[self copy]];
+    }
+    
+    // Traits cached before interning was enabled are swapped for their canonical instances.
+    return (trait != [NSNull null]) ? GNKTraitIntern(trait) : nil;
+}
+
+- (id)_GNKParsedTraitValue
 {
     NSArray *keyPaths = [self componentsSeparatedByString:@"."];
     NSMutableArray *traits = [NSMutableArray array];
@@ -0,0 +1,79 @@
+//
+//  GNKTrait_Private.h
+//  GeneticsKit
+//
+//  Created by Zach Radke on 3/25/15.
+//  Copyright (c) 2015 Zach Radke. All rights reserved.
+//
+
+#import "GNKTrait.h"
+
+/**
+ *  Returns the canonical instance of the trait if interning is enabled. If interning is disabled, or the trait is not a GNKTrait, the trait is returned unchanged.
+ *
+ *  @see +[GNKTrait setInterningEnabled:]
+ *
+ *  @param trait The trait to intern.
+ *
+ *  @return The canonical instance of the trait.
+ */
+FOUNDATION_EXTERN id GNKTraitIntern(id trait);
+
+/**
+ *  Checks if the trait was created with +[GNKTrait traitWithKey:].
+ *
+ *  @param trait The trait to check.
+ *
+ *  @return YES if the trait is a key trait, NO if it is not.
+ */
+FOUNDATION_EXTERN BOOL GNKTraitIsKeyTrait(id trait);
+
+/**
+ *  Returns the traits followed by a trait created with +[GNKTrait sequenceOfTraits:].
+ *
+ *  @param trait The trait whose sequence to return.
+ *
+ *  @return The flattened array of traits in the sequence, or nil if the trait is not a sequence.
+ */
+FOUNDATION_EXTERN NSArray *GNKTraitSequence(id trait);
+
+/**
+ *  Copies a scalar value from the source object to the receiving object without boxing it. This only succeeds if neither key trait uses collection operators, and the source object's getter and the receiving object's setter for the final keys of the key paths are methods of the same scalar type.
+ *
+ *  @param sourceTrait    The key trait used to get the value from the source object.
+ *  @param source         The source object.
+ *  @param receivingTrait The key trait used to set the value on the receiving object.
+ *  @param receiver       The receiving object.
+ *
+ *  @return YES if the value was copied, NO if it must be transfered through the traits instead.
+ */
+FOUNDATION_EXTERN BOOL GNKTraitCopyScalarValue(id sourceTrait, id source, id receivingTrait, id receiver);
+
+/**
+ *  Returns the path the trait follows through nested collections, such as those parsed from JSON.
+ *
+ *  @param trait The source trait whose path to return.
+ *
+ *  @return An array of NSString keys and NSNumber indexes, in the order they are followed, or nil if the trait cannot be expressed as a path. This is the case for aggregate traits, identity traits, negative indexes, keys which use collection operators, and traits which are not GNKTraits.
+ */
+FOUNDATION_EXTERN NSArray *GNKTraitPathComponents(id trait);
+
+/**
+ *  Returns the single key or index a receiving trait sets a value for when the receiver is a mutable dictionary or array.
+ *
+ *  @param trait The receiving trait whose key or index to return.
+ *
+ *  @return The key of a key trait as an NSString, or the index of an index trait as an NSNumber, or nil if the trait does not set a single element of a collection. This is the case for keys with more than one segment or which use collection operators, negative indexes, and every other kind of trait. Keys are retained by their traits.
+ */
+FOUNDATION_EXTERN id GNKTraitCollectionComponent(id trait);
+
+/**
+ *  Returns the key paths which can be observed with key-value observing to detect every change to the trait's value on an object.
+ *
+ *  Key traits are observed through their key path. Sequences of traits are observed through the key path formed by their leading key traits, and may end with a single index trait since replacing or mutating the indexed collection through key-value coding notifies observers of that key path. Aggregate traits are observed through the key paths of all their traits.
+ *
+ *  @param trait The source trait to observe.
+ *
+ *  @return An array of key path strings, or nil if changes to the trait's value cannot be fully observed. This is the case for index traits on their own, identity traits, keys which use collection operators, traits which are not GNKTraits, and sequences which continue past an index trait.
+ */
+FOUNDATION_EXTERN NSArray *GNKTraitObservableKeyPaths(id trait);
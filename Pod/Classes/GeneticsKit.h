@@ -7,5 +7,13 @@
 //
 
 #import <GeneticsKit/GNKGene.h>
+#import <GeneticsKit/GNKGenome.h>
 #import <GeneticsKit/GNKTraitConvertible.h>
 #import <GeneticsKit/GNKLab.h>
+#import <GeneticsKit/GNKTrackingSession.h>
+#import <GeneticsKit/GNKMemoizingTransformer.h>
+#import <GeneticsKit/GNKBatchValueTransformer.h>
+#import <GeneticsKit/GNKExpensiveValueTransformer.h>
+#import <GeneticsKit/GNKChangeBatchingReceiver.h>
+#import <GeneticsKit/GNKGeneStatistics.h>
+#import <GeneticsKit/GNKPatch.h>